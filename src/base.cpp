@@ -1,74 +1,248 @@
 #include "base.hpp"
+#include "filter.hpp"
+#include "lanczos.hpp"
+#include "thread_group.hpp"
+#include "work_stealing_pool.hpp"
+#include <atomic>
+#include <numeric>
 
 namespace lpn
 {
 
 namespace math = boost::multiprecision;
 
-bool FactorizationBase::IsPerfectSquare(const Line & line) { return line.IsMaskEmpty(); }
+Solution::Solution(const std::vector<size_t> & primes) : factors(primes), primes(primes) {}
 
-std::vector<size_t> FactorizationBase::GetParticipantsPositions(const Line & line)
+NullSpace::NullSpace(const Solution & solution, LinearSolver solver, bool multi_thread)
+    : filter_(std::make_unique<RelationFilter>(solution))
 {
-    std::vector<size_t> positions;
-    for (size_t i = 0; i < line.participants.size(); ++i)
+    if (solver == LinearSolver::kBlockLanczos)
     {
-        if (line.participants[i])
+        dependencies_ = BlockLanczos(filter_->GetFactors()).Solve();
+    }
+    if (dependencies_.empty())
+    {
+        gaussian_ = std::make_unique<GaussianBasic>(filter_->GetFactors(), multi_thread);
+        gaussian_->Solve();
+    }
+}
+
+NullSpace::NullSpace(NullSpace && other) noexcept = default;
+
+NullSpace::~NullSpace() = default;
+
+std::optional<NullSpace::Dependency> NullSpace::Next()
+{
+    while (true)
+    {
+        std::optional<Dependency> dependency;
+        if (!dependencies_.empty())
+        {
+            dependency = std::move(dependencies_.back());
+            dependencies_.pop_back();
+        }
+        else if (gaussian_)
         {
-            positions.push_back(i);
+            dependency = gaussian_->NextDependency();
+        }
+        if (!dependency.has_value())
+        {
+            return std::nullopt;
+        }
+        auto expanded = filter_->Expand(dependency.value());
+        if (!expanded.empty())
+        {
+            return expanded;
         }
     }
-    return positions;
 }
 
-FactorSet FactorizationBase::FindFactor(const Solution & solution, const Matrix & matrix, const long_int & n)
+NullSpace FactorizationBase::SolveLinearSystem(const Solution & solution, LinearSolver solver, bool multi_thread)
+{
+    return NullSpace(solution, solver, multi_thread);
+}
+
+FactorSet FactorizationBase::FindFactor(const Solution & solution, NullSpace & null_space, const long_int & n,
+                                        bool multi_thread)
 {
-    FactorSet factor;
-    for (const auto & line : matrix)
+    size_t threads = multi_thread ? ThreadGroup::GetThreadAmount() : 1;
+    std::unique_ptr<WorkStealingPool> pool;
+    if (threads > 1)
+    {
+        pool = std::make_unique<WorkStealingPool>(threads);
+    }
+    size_t batch_size = pool ? threads * kDependenciesPerThread : 1;
+
+    std::vector<Dependency> batch;
+    std::vector<std::optional<FactorSet>> factors;
+    std::atomic<bool> found = false;
+    while (true)
     {
-        if (IsPerfectSquare(line))
+        batch.clear();
+        for (auto positions = null_space.Next(); positions.has_value(); positions = null_space.Next())
         {
-            auto positions = GetParticipantsPositions(line);
-            long_int x = ComputeX(solution, positions, n);
-            long_int y = ComputeY(solution, positions, n);
-            long_int gcd = lpn::gcd<long_int>(math::abs(x - y), n);
-            if (gcd != 1 && gcd != n)
+            batch.push_back(std::move(positions.value()));
+            if (batch.size() == batch_size)
             {
-                factor[gcd] = 1;
-                factor[n / gcd] = 1;
-                return factor;
+                break;
+            }
+        }
+        if (batch.empty())
+        {
+            return FactorSet{{n, 1}};
+        }
+
+        factors.assign(batch.size(), std::nullopt);
+        auto task = [&solution, &n, &batch, &factors, &found](size_t pos)
+        {
+            if (!found)
+            {
+                factors[pos] = TryDependency(solution, batch[pos], n);
+                if (factors[pos].has_value())
+                {
+                    found = true;
+                }
+            }
+        };
+        for (size_t pos = 0; pos < batch.size(); ++pos)
+        {
+            if (pool)
+            {
+                pool->AddTask([&task, pos](size_t) { task(pos); });
+            }
+            else
+            {
+                task(pos);
+            }
+        }
+        if (pool)
+        {
+            pool->Wait();
+        }
+        // the tasks started before the first factor was found may have found others, the earliest one is taken
+        for (auto & factor : factors)
+        {
+            if (factor.has_value())
+            {
+                return factor.value();
             }
         }
     }
-    factor[n] = 1;
-    return factor;
 }
 
-long_int FactorizationBase::ComputeY(const Solution & solution, const std::vector<size_t> & positions,
+std::optional<FactorSet> FactorizationBase::TryDependency(const Solution & solution, const Dependency & positions,
+                                                          const long_int & n)
+{
+    long_int x = ComputeX(solution, positions, n);
+    long_int y = ComputeY(solution, positions, n);
+    long_int gcd = lpn::gcd<long_int>(math::abs(x - y), n);
+    if (gcd == 1 || gcd == n)
+    {
+        return std::nullopt;
+    }
+    return FactorSet{{gcd, 1}, {n / gcd, 1}};
+}
+
+IncrementalSolver::IncrementalSolver(const long_int & n, size_t base_size)
+    : n_(n), gaussian_(base_size), relations_(0)
+{
+}
+
+bool IncrementalSolver::Update(Solution & solution)
+{
+    for (; relations_ < solution.factors.Size() && solution.factor.empty(); ++relations_)
+    {
+        auto positions = gaussian_.Add(solution.factors, relations_);
+        if (positions.has_value())
+        {
+            solution.factor = TryDependency(solution, positions.value(), n_).value_or(FactorSet());
+        }
+    }
+    return !solution.factor.empty();
+}
+
+std::optional<Solution> IncrementalSolver::NextDependency(const Solution & solution)
+{
+    while (relations_ < solution.factors.Size())
+    {
+        auto positions = gaussian_.Add(solution.factors, relations_++);
+        if (positions.has_value())
+        {
+            Solution dependency;
+            dependency.factors = solution.factors.Select(positions.value());
+            for (auto pos : positions.value())
+            {
+                dependency.values.push_back(solution.values[pos]);
+            }
+            return dependency;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<FactorSet> IncrementalSolver::TryCopiedDependency(const Solution & dependency) const
+{
+    Dependency positions(dependency.values.size());
+    std::iota(positions.begin(), positions.end(), 0);
+    return TryDependency(dependency, positions, n_);
+}
+
+long_int FactorizationBase::ComputeY(const Solution & solution, const Dependency & positions,
                                      const long_int & n)
 {
-    long_int y = 1;
-    FactorSet factor;
+    // the exponents are summed by prime index, an even power of -1 is skipped
+    std::vector<size_t> powers(solution.factors.GetPrimeAmount(), 0);
     for (auto pos : positions)
     {
-        MergeFactorSets(factor, solution.factors[pos]);
+        auto indices = solution.factors.GetIndices(pos);
+        auto factor_powers = solution.factors.GetPowers(pos);
+        for (size_t k = 0; k < indices.size(); ++k)
+        {
+            if (indices[k] != Relations::kSign)
+            {
+                powers[indices[k]] += factor_powers[k];
+            }
+        }
     }
-    for (auto [key, value] : factor)
+    std::vector<long_int> operands;
+    for (size_t index = 0; index < powers.size(); ++index)
     {
-        assert(value % 2 == 0);
-        y = (y * FastExponentiationWithMod(key, value / 2, n)) % n;
+        assert(powers[index] % 2 == 0);
+        if (powers[index] > 0)
+        {
+            operands.push_back(math::pow(long_int(solution.factors.GetPrime(index)), unsigned(powers[index] / 2)));
+        }
     }
-    return y;
+    return MultiplyTree(operands, n);
 }
 
-long_int FactorizationBase::ComputeX(const Solution & solution, const std::vector<size_t> & positions,
+long_int FactorizationBase::ComputeX(const Solution & solution, const Dependency & positions,
                                      const long_int & n)
 {
-    long_int x = 1;
+    std::vector<long_int> operands;
+    operands.reserve(positions.size());
     for (auto pos : positions)
     {
-        x = (x * solution.values[pos]) % n;
+        operands.push_back(solution.values[pos]);
+    }
+    return MultiplyTree(operands, n);
+}
+
+long_int FactorizationBase::MultiplyTree(std::vector<long_int> & operands, const long_int & n)
+{
+    // the small operands are multiplied exactly for a few levels, so a product is reduced only once it passes n
+    for (size_t step = 1; step < operands.size(); step *= 2)
+    {
+        for (size_t pos = 0; pos + step < operands.size(); pos += 2 * step)
+        {
+            operands[pos] *= operands[pos + step];
+            if (operands[pos] >= n)
+            {
+                operands[pos] %= n;
+            }
+        }
     }
-    return x;
+    return operands.empty() ? long_int(1) : long_int(operands[0] % n);
 }
 
 };  // namespace lpn
@@ -1,28 +1,101 @@
 #pragma once
 
 #include "gaussian.hpp"
+#include "relations.hpp"
 #include <boost/multiprecision/cpp_int.hpp>
 
 namespace lpn
 {
 
+// Relations values[i]^2 = Eval(factors.GetFactor(i)) mod n over the factor base primes, a negative relation has the
+// factor -1
 struct Solution
 {
-    FactorSets factors;
+    Solution() = default;
+    explicit Solution(const std::vector<size_t> & primes);
+
+    Relations factors;
     std::vector<long_int> values;
     std::vector<size_t> primes;
+    // the factor found by IncrementalSolver while the relations were collected, empty when none
+    FactorSet factor;
+    // false when the sieve ran out of polynomials or of its interval before the target amount of relations
+    bool complete = true;
+};
+
+// GaussianBasic is dense and cubic in the factor base, BlockLanczos is sparse and pays off on large factor bases.
+// kIncremental reduces every relation as it is found and stops the collection at the first factor, GaussianBasic
+// runs when all the relations are collected without one.
+enum class LinearSolver
+{
+    kGaussian,
+    kBlockLanczos,
+    kIncremental,
+};
+
+class RelationFilter;
+
+// Dependencies between the relations of a solution, taken one at a time. The relations are filtered by
+// RelationFilter, Block Lanczos finds its few dependencies at once and falls back to Gaussian elimination when it
+// finds none, the dependencies of Gaussian elimination are read from the reduced matrix when they are taken.
+class NullSpace
+{
+   public:
+    using Dependency = GaussianBasic::Dependency;
+
+    NullSpace(const Solution & solution, LinearSolver solver, bool multi_thread = false);
+    NullSpace(NullSpace && other) noexcept;
+    ~NullSpace();
+
+    // positions of the relations of the solution, nullopt after the last dependency
+    std::optional<Dependency> Next();
+
+   private:
+    std::unique_ptr<RelationFilter> filter_;
+    std::vector<Dependency> dependencies_;
+    std::unique_ptr<GaussianBasic> gaussian_;
 };
 
 class FactorizationBase
 {
+   private:
+    static constexpr size_t kDependenciesPerThread = 2;
+
    protected:
-    using Matrix = GaussianBasic::Matrix;
-    using Line = GaussianBasic::Line;
-
-    static bool IsPerfectSquare(const Line & line);
-    static std::vector<size_t> GetParticipantsPositions(const Line & line);
-    static FactorSet FindFactor(const Solution & solution, const Matrix & matrix, const long_int & n);
-    static long_int ComputeY(const Solution & solution, const std::vector<size_t> & positions, const long_int & n);
-    static long_int ComputeX(const Solution & solution, const std::vector<size_t> & positions, const long_int & n);
+    using Dependency = NullSpace::Dependency;
+
+    static NullSpace SolveLinearSystem(const Solution & solution, LinearSolver solver, bool multi_thread = false);
+    // the dependencies are taken until one of them gives a nontrivial factor, with multi_thread a batch of them is
+    // tried at once and the rest of the batch is skipped after a factor
+    static FactorSet FindFactor(const Solution & solution, NullSpace & null_space, const long_int & n,
+                                bool multi_thread = false);
+    // the factors gcd(x - y, n) and n / gcd(x - y, n) of a dependency, nullopt when they are trivial
+    static std::optional<FactorSet> TryDependency(const Solution & solution, const Dependency & positions,
+                                                  const long_int & n);
+    static long_int ComputeY(const Solution & solution, const Dependency & positions, const long_int & n);
+    static long_int ComputeX(const Solution & solution, const Dependency & positions, const long_int & n);
+    // the product modulo n, the operands are multiplied pairwise level by level
+    static long_int MultiplyTree(std::vector<long_int> & operands, const long_int & n);
+};
+
+// Tries the dependencies of the relations of a solution while they are collected: the relations go through
+// IncrementalGaussian as they are added and every dependency is checked for a factor at once.
+class IncrementalSolver : private FactorizationBase
+{
+   public:
+    IncrementalSolver(const long_int & n, size_t base_size);
+
+    // reduces the relations added since the last call, the first nontrivial factor goes to solution.factor
+    bool Update(Solution & solution);
+
+    // Update in two steps: the next dependency of the relations added since the last call is copied out of the
+    // solution, so that its square root can be taken while the solution is changed by others
+    std::optional<Solution> NextDependency(const Solution & solution);
+    std::optional<FactorSet> TryCopiedDependency(const Solution & dependency) const;
+
+   private:
+    long_int n_;
+    IncrementalGaussian gaussian_;
+    size_t relations_;
 };
 };  // namespace lpn
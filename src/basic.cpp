@@ -1,4 +1,5 @@
 #include "basic.hpp"
+#include <algorithm>
 #include <cassert>
 
 namespace lpn
@@ -39,6 +40,24 @@ long_int FastExponentiationWithMod(long_int a, long_int b, const long_int & m)
     return n;
 }
 
+size_t InverseWithMod(size_t a, size_t m)
+{
+    assert(m > 0);
+
+    int64_t x0 = 1;
+    int64_t x1 = 0;
+    int64_t b = int64_t(m);
+    int64_t c = int64_t(a % m);
+    while (b != 0)
+    {
+        int64_t q = c / b;
+        c = std::exchange(b, c - q * b);
+        x0 = std::exchange(x1, x0 - q * x1);
+    }
+    assert(c == 1 || m == 1);
+    return size_t(x0 < 0 ? x0 + int64_t(m) : x0) % m;
+}
+
 long_int FastExponentiation(long_int a, long_int b)
 {
     assert(b >= 0);
@@ -155,4 +174,66 @@ long_int PowBasic(const long_int & a, long_int b)
     return answer;
 }
 
+std::vector<size_t> SievePrimes(size_t begin, size_t end)
+{
+    constexpr size_t kSegmentSize = 1 << 16;
+    std::vector<size_t> primes;
+    if (end <= 3)
+    {
+        return primes;
+    }
+
+    // odd primes up to sqrt(end) cross out the segments
+    size_t root = 1;
+    while ((root + 1) * (root + 1) < end)
+    {
+        ++root;
+    }
+    std::vector<bool> composite(root + 1, false);
+    std::vector<size_t> base;
+    for (size_t p = 3; p <= root; p += 2)
+    {
+        if (!composite[p])
+        {
+            base.push_back(p);
+            for (size_t q = p * p; q <= root; q += 2 * p)
+            {
+                composite[q] = true;
+            }
+        }
+    }
+
+    std::vector<uint8_t> segment(kSegmentSize);
+    for (size_t left = std::max<size_t>(begin, 3) | 1; left < end; left += 2 * kSegmentSize)
+    {
+        // segment[k] stands for the odd number left + 2k
+        size_t right = std::min(end, left + 2 * kSegmentSize);
+        std::fill(segment.begin(), segment.end(), 0);
+        for (size_t p : base)
+        {
+            if (p * p >= right)
+            {
+                break;
+            }
+            size_t first = std::max(p * p, (left + p - 1) / p * p);
+            if (first % 2 == 0)
+            {
+                first += p;
+            }
+            for (size_t q = first; q < right; q += 2 * p)
+            {
+                segment[(q - left) / 2] = 1;
+            }
+        }
+        for (size_t k = 0; left + 2 * k < right; ++k)
+        {
+            if (segment[k] == 0)
+            {
+                primes.push_back(left + 2 * k);
+            }
+        }
+    }
+    return primes;
+}
+
 };  // namespace lpn
@@ -13,6 +13,8 @@ long_int Eval(const FactorSet & factor);
 long_int FastExponentiation(long_int a, long_int b);
 long_int FastExponentiationWithMod(long_int a, long_int b, const long_int & m);
 
+size_t InverseWithMod(size_t a, size_t m);
+
 size_t ExtractPower(long_int & a, const long_int & b);
 size_t ExtractPowerFast(long_int & a, const long_int & b);
 
@@ -70,9 +72,8 @@ bool IsStrongPseudoPrime(const long_int & p, const Container & primes)
 }
 
 template <typename Container>
-static std::optional<FactorSet> TryToDecompose(const Container & primes, long_int n)
+static void ExtractFactors(const Container & primes, long_int & n, FactorSet & factor)
 {
-    FactorSet factor;
     for (size_t i = 0; i < primes.size() && n > 1; ++i)
     {
         if (n % primes[i] == 0)
@@ -80,6 +81,13 @@ static std::optional<FactorSet> TryToDecompose(const Container & primes, long_in
             factor[primes[i]] += ExtractPowerFast(n, primes[i]);
         }
     }
+}
+
+template <typename Container>
+static std::optional<FactorSet> TryToDecompose(const Container & primes, long_int n)
+{
+    FactorSet factor;
+    ExtractFactors(primes, n, factor);
     return n == 1 ? std::optional<FactorSet>(factor) : std::nullopt;
 }
 
@@ -87,6 +95,9 @@ FactorSet FactorizeBasic(long_int a);
 
 bool IsPrimeBasic(const long_int & a);
 
+// odd primes in [begin, end) by a segmented sieve of Eratosthenes
+std::vector<size_t> SievePrimes(size_t begin, size_t end);
+
 long_int PowBasic(const long_int & a, long_int b);
 
 };  // namespace lpn
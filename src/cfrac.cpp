@@ -23,37 +23,114 @@ void ContinuedFractions::State::Update()
     p0 = std::exchange<long_int, long_int>(p1, (p0 + a * p1) % n);
 }
 
-Solution ContinuedFractions::Solve(const long_int & n, size_t factor_size)
+std::vector<long_int> ContinuedFractions::State::Save() const { return {a, b0, b1, c0, c1, p0, p1}; }
+
+void ContinuedFractions::State::Restore(const std::vector<long_int> & progress)
+{
+    a = progress[0];
+    b0 = progress[1];
+    b1 = progress[2];
+    c0 = progress[3];
+    c1 = progress[4];
+    p0 = progress[5];
+    p1 = progress[6];
+}
+
+Solution ContinuedFractions::Solve(const long_int & n, size_t factor_size, const std::string & checkpoint,
+                                   LinearSolver solver)
 {
     State state(n);
-    Solution solution;
-    solution.primes = FindQuadraticResiduePrimes(n, factor_size);
-    while (solution.factors.size() < 1.1 * solution.primes.size())
+    Solution solution(FindQuadraticResiduePrimes(n, factor_size));
+    std::unique_ptr<RelationFile> file;
+    if (!checkpoint.empty())
     {
+        file = std::make_unique<RelationFile>(checkpoint, n, solution.primes);
+        LoadCheckpoint(*file, state, solution);
+    }
+    std::unique_ptr<IncrementalSolver> incremental;
+    if (solver == LinearSolver::kIncremental)
+    {
+        incremental = std::make_unique<IncrementalSolver>(n, solution.primes.size());
+    }
+
+    while (solution.factors.Size() < 1.1 * solution.primes.size())
+    {
+        if (incremental && incremental->Update(solution))
+        {
+            break;
+        }
         state.Update();
         auto factor = TryToDecompose(solution.primes, state.c1);
-        AddFactor(factor, state, solution);
+        AddFactor(factor, state, solution, file.get());
     }
     return solution;
 }
 
-void ContinuedFractions::AddFactor(const std::optional<FactorSet> & factor, const State & state, Solution & solution)
+void ContinuedFractions::AddFactor(const std::optional<FactorSet> & factor, const State & state, Solution & solution,
+                                   RelationFile * file)
 {
-    if (factor.has_value())
+    if (!factor.has_value())
+    {
+        return;
+    }
+    FactorSet relation = factor.value();
+    // p^2 = (-1)^k c mod n, the sign alternates along the expansion
+    if ((state.p1 * state.p1) % state.n != state.c1)
+    {
+        relation[-1] = 1;
+    }
+    if (file != nullptr)
+    {
+        // relations found after the last saved state are met again on resume
+        if (file->Contains(state.p1))
+        {
+            return;
+        }
+        file->AddRelation({state.p1, relation});
+    }
+    solution.factors.Add(relation);
+    solution.values.push_back(state.p1);
+    if (file != nullptr && solution.factors.Size() % kProgressInterval == 0)
     {
-        solution.factors.push_back(std::move(factor.value()));
-        solution.values.push_back(state.p1);
+        file->AddProgress(state.Save());
     }
 }
 
-FactorSet ContinuedFractionsFactorization::Factorize(const long_int & n) { return Factorize(n, kBasicFactorSize); }
+void ContinuedFractions::LoadCheckpoint(const RelationFile & file, State & state, Solution & solution)
+{
+    for (const auto & relation : file.GetRelations())
+    {
+        solution.values.push_back(relation.value);
+        solution.factors.Add(relation.factor);
+    }
+    const auto & progress = file.GetProgress();
+    if (!progress.empty())
+    {
+        state.Restore(progress.back());
+    }
+}
+
+FactorSet ContinuedFractionsFactorization::Factorize(const long_int & n)
+{
+    return Factorize(n, kBasicFactorSize, "");
+}
 
 FactorSet ContinuedFractionsFactorization::Factorize(const long_int & n, size_t factor_size)
 {
-    auto solution = ContinuedFractions::Solve(n, factor_size);
-    GaussianBasic gs = GaussianBasic(solution.factors, solution.primes);
-    auto matrix = gs.Solve();
-    return FindFactor(solution, matrix, n);
+    return Factorize(n, factor_size, "");
+}
+
+FactorSet ContinuedFractionsFactorization::Factorize(const long_int & n, size_t factor_size,
+                                                     const std::string & checkpoint, LinearSolver solver,
+                                                     bool multi_thread)
+{
+    auto solution = ContinuedFractions::Solve(n, factor_size, checkpoint, solver);
+    if (!solution.factor.empty())
+    {
+        return solution.factor;
+    }
+    auto null_space = SolveLinearSystem(solution, solver, multi_thread);
+    return FindFactor(solution, null_space, n, multi_thread);
 }
 
 };  // namespace lpn
@@ -3,8 +3,11 @@
 #include "aliases.hpp"
 #include "base.hpp"
 #include "basic.hpp"
+#include "checkpoint.hpp"
 #include "gaussian.hpp"
 
+#include <string>
+
 namespace lpn
 {
 
@@ -16,6 +19,8 @@ class ContinuedFractions
         explicit State(const long_int & n);
 
         void Update();
+        std::vector<long_int> Save() const;
+        void Restore(const std::vector<long_int> & progress);
 
         long_int n;
         long_int sqrt_n;
@@ -28,11 +33,17 @@ class ContinuedFractions
         long_int p1;
     };
 
+    static constexpr size_t kProgressInterval = 64;
+
    public:
-    static Solution Solve(const long_int & n, size_t factor_size);
+    // with LinearSolver::kIncremental the expansion stops at the first factor
+    static Solution Solve(const long_int & n, size_t factor_size, const std::string & checkpoint = "",
+                          LinearSolver solver = LinearSolver::kGaussian);
 
    private:
-    static void AddFactor(const std::optional<FactorSet> & factor, const State & state, Solution & solution);
+    static void AddFactor(const std::optional<FactorSet> & factor, const State & state, Solution & solution,
+                          RelationFile * file);
+    static void LoadCheckpoint(const RelationFile & file, State & state, Solution & solution);
 };
 
 class ContinuedFractionsFactorization : private FactorizationBase
@@ -40,6 +51,8 @@ class ContinuedFractionsFactorization : private FactorizationBase
    public:
     static FactorSet Factorize(const long_int & n);
     static FactorSet Factorize(const long_int & n, size_t factor_size);
+    static FactorSet Factorize(const long_int & n, size_t factor_size, const std::string & checkpoint,
+                               LinearSolver solver = LinearSolver::kGaussian, bool multi_thread = false);
 
    private:
     static constexpr size_t kBasicFactorSize = 4000;
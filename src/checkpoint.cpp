@@ -0,0 +1,299 @@
+#include "checkpoint.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+
+namespace lpn
+{
+
+namespace math = boost::multiprecision;
+
+// Bounds checked reading of the loaded file, every method fails once the data ends
+class RelationFile::Reader
+{
+   public:
+    explicit Reader(const std::vector<char> & data) : data_(data), offset_(0) {}
+
+    template <typename T>
+    bool Read(T & value)
+    {
+        if (data_.size() - offset_ < sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&value, data_.data() + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return true;
+    }
+
+    bool ReadNumber(long_int & value)
+    {
+        uint8_t sign;
+        uint32_t length;
+        if (!Read(sign) || !Read(length) || data_.size() - offset_ < length)
+        {
+            return false;
+        }
+        auto begin = reinterpret_cast<const uint8_t *>(data_.data() + offset_);
+        value = 0;
+        math::import_bits(value, begin, begin + length);
+        if (sign != 0)
+        {
+            value = -value;
+        }
+        offset_ += length;
+        return true;
+    }
+
+    size_t GetOffset() const { return offset_; }
+
+   private:
+    const std::vector<char> & data_;
+    size_t offset_;
+};
+
+RelationFile::RelationFile(const std::string & path, const long_int & n, const std::vector<size_t> & primes)
+    : path_(path), primes_(primes), buffered_(0)
+{
+    for (size_t pos = 0; pos < primes.size(); ++pos)
+    {
+        indices_[primes[pos]] = uint32_t(pos);
+    }
+
+    if (Load(n))
+    {
+        file_.open(path_, std::ios::binary | std::ios::app);
+        return;
+    }
+    relations_.clear();
+    progress_.clear();
+    values_.clear();
+    file_.open(path_, std::ios::binary | std::ios::trunc);
+    WriteHeader(n);
+    Flush();
+}
+
+RelationFile::~RelationFile() { Flush(); }
+
+const std::vector<RelationFile::Relation> & RelationFile::GetRelations() const { return relations_; }
+
+const std::vector<std::vector<long_int>> & RelationFile::GetProgress() const { return progress_; }
+
+bool RelationFile::Contains(const long_int & value) const { return values_.contains(value); }
+
+void RelationFile::AddRelation(const Relation & relation)
+{
+    std::lock_guard lock(mutex_);
+    bool partial = relation.second != 1;
+    Write(partial ? Record::kPartial : Record::kFull);
+    WriteNumber(relation.value);
+    WriteFactor(relation.factor);
+    if (partial)
+    {
+        Write(uint64_t(relation.first));
+        Write(uint64_t(relation.second));
+    }
+    if (++buffered_ >= kFlushRelations)
+    {
+        WriteBuffer();
+    }
+}
+
+void RelationFile::AddProgress(const std::vector<long_int> & progress)
+{
+    {
+        std::lock_guard lock(mutex_);
+        Write(Record::kProgress);
+        Write(uint32_t(progress.size()));
+        for (const auto & value : progress)
+        {
+            WriteNumber(value);
+        }
+    }
+    Flush();
+}
+
+void RelationFile::Flush()
+{
+    std::lock_guard lock(mutex_);
+    WriteBuffer();
+}
+
+void RelationFile::WriteBuffer()
+{
+    file_.write(buffer_.data(), std::streamsize(buffer_.size()));
+    file_.flush();
+    buffer_.clear();
+    buffered_ = 0;
+}
+
+size_t RelationFile::Read(const std::string & path, const long_int & n, const std::vector<size_t> & primes,
+                          size_t offset, std::vector<Relation> & relations,
+                          std::vector<std::vector<long_int>> & progress)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input || !input.seekg(std::streamoff(offset)))
+    {
+        return 0;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    Reader reader(data);
+    if (offset == 0 && !ReadHeader(reader, n, primes))
+    {
+        return 0;
+    }
+
+    size_t valid = reader.GetOffset();
+    Record type;
+    while (reader.Read(type))
+    {
+        if (type == Record::kProgress)
+        {
+            uint32_t count;
+            std::vector<long_int> values;
+            bool complete = reader.Read(count);
+            for (uint32_t k = 0; complete && k < count; ++k)
+            {
+                complete = reader.ReadNumber(values.emplace_back());
+            }
+            if (!complete)
+            {
+                break;
+            }
+            progress.push_back(std::move(values));
+        }
+        else if (type == Record::kFull || type == Record::kPartial)
+        {
+            Relation relation;
+            if (!ReadRelation(reader, type, primes, relation))
+            {
+                break;
+            }
+            relations.push_back(std::move(relation));
+        }
+        else
+        {
+            // an unknown type is garbage after the last record, it ends the valid data like a torn tail
+            break;
+        }
+        valid = reader.GetOffset();
+    }
+    return offset + valid;
+}
+
+bool RelationFile::Load(const long_int & n)
+{
+    // a file of another number or factor base is started over
+    size_t valid = Read(path_, n, primes_, 0, relations_, progress_);
+    if (valid == 0)
+    {
+        return false;
+    }
+    for (const auto & relation : relations_)
+    {
+        values_.insert(relation.value);
+    }
+    // the next records are appended right after the last complete one
+    std::filesystem::resize_file(path_, valid);
+    return true;
+}
+
+bool RelationFile::ReadHeader(Reader & reader, const long_int & n, const std::vector<size_t> & primes)
+{
+    uint32_t magic, version;
+    long_int stored_n;
+    uint64_t size, last;
+    return reader.Read(magic) && reader.Read(version) && reader.ReadNumber(stored_n) && reader.Read(size) &&
+           reader.Read(last) && magic == kMagic && version == kVersion && stored_n == n && size == primes.size() &&
+           (size == 0 || last == primes.back());
+}
+
+bool RelationFile::ReadRelation(Reader & reader, Record type, const std::vector<size_t> & primes, Relation & relation)
+{
+    uint32_t count;
+    if (!reader.ReadNumber(relation.value) || !reader.Read(count))
+    {
+        return false;
+    }
+    for (uint32_t k = 0; k < count; ++k)
+    {
+        uint32_t index, power;
+        long_int prime;
+        if (!reader.Read(index))
+        {
+            return false;
+        }
+        if (index == kRawPrime)
+        {
+            if (!reader.ReadNumber(prime))
+            {
+                return false;
+            }
+        }
+        else if (index < primes.size())
+        {
+            prime = primes[index];
+        }
+        else
+        {
+            return false;
+        }
+        if (!reader.Read(power))
+        {
+            return false;
+        }
+        relation.factor[prime] = power;
+    }
+    if (type == Record::kPartial)
+    {
+        uint64_t first, second;
+        if (!reader.Read(first) || !reader.Read(second))
+        {
+            return false;
+        }
+        relation.first = first;
+        relation.second = second;
+    }
+    return true;
+}
+
+void RelationFile::WriteHeader(const long_int & n)
+{
+    Write(kMagic);
+    Write(kVersion);
+    WriteNumber(n);
+    Write(uint64_t(primes_.size()));
+    Write(uint64_t(primes_.empty() ? 0 : primes_.back()));
+}
+
+void RelationFile::WriteFactor(const FactorSet & factor)
+{
+    Write(uint32_t(factor.size()));
+    for (const auto & [prime, power] : factor)
+    {
+        // primes outside of the factor base (large primes) are stored as numbers
+        auto index = prime > 0 && prime <= SIZE_MAX ? indices_.find(size_t(prime)) : indices_.end();
+        if (index != indices_.end())
+        {
+            Write(index->second);
+        }
+        else
+        {
+            Write(kRawPrime);
+            WriteNumber(prime);
+        }
+        Write(uint32_t(power));
+    }
+}
+
+void RelationFile::WriteNumber(const long_int & value)
+{
+    std::vector<uint8_t> bytes;
+    math::export_bits(long_int(math::abs(value)), std::back_inserter(bytes), 8);
+    Write(uint8_t(value < 0));
+    Write(uint32_t(bytes.size()));
+    buffer_.insert(buffer_.end(), bytes.begin(), bytes.end());
+}
+
+};  // namespace lpn
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "aliases.hpp"
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace lpn
+{
+
+// Append-only binary file of relations, so that a long run can be resumed after it is killed. The file starts with
+// a header (n and the factor base), every record is a full or a partial relation with its value and the sparse list
+// of (factor base index, exponent) pairs, or a progress mark of the sieve. A torn record at the end is dropped on load.
+class RelationFile
+{
+   private:
+    static constexpr uint32_t kMagic = 0x524e504c;  // "LPNR"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kRawPrime = UINT32_MAX;
+    static constexpr size_t kFlushRelations = 128;
+
+    enum class Record : uint8_t
+    {
+        kFull = 0,
+        kPartial = 1,
+        kProgress = 2,
+    };
+
+   public:
+    struct Relation
+    {
+        long_int value;
+        FactorSet factor;
+        // large primes of a partial relation, 1 for a full relation or a single large prime
+        size_t first = 1;
+        size_t second = 1;
+    };
+
+    RelationFile(const std::string & path, const long_int & n, const std::vector<size_t> & primes);
+    ~RelationFile();
+
+    // complete records appended after the offset, also while another process writes the file; the returned offset
+    // is where the next read starts, zero for a missing file or another number
+    static size_t Read(const std::string & path, const long_int & n, const std::vector<size_t> & primes,
+                       size_t offset, std::vector<Relation> & relations, std::vector<std::vector<long_int>> & progress);
+
+    // relations and progress marks of the previous runs on the same n and factor base
+    const std::vector<Relation> & GetRelations() const;
+    const std::vector<std::vector<long_int>> & GetProgress() const;
+    bool Contains(const long_int & value) const;
+
+    void AddRelation(const Relation & relation);
+    void AddProgress(const std::vector<long_int> & progress);
+    void Flush();
+
+   private:
+    class Reader;
+
+    static bool ReadHeader(Reader & reader, const long_int & n, const std::vector<size_t> & primes);
+    static bool ReadRelation(Reader & reader, Record type, const std::vector<size_t> & primes, Relation & relation);
+
+    bool Load(const long_int & n);
+    void WriteBuffer();
+    void WriteHeader(const long_int & n);
+    void WriteFactor(const FactorSet & factor);
+    void WriteNumber(const long_int & value);
+
+    template <typename T>
+    void Write(T value)
+    {
+        auto bytes = reinterpret_cast<const char *>(&value);
+        buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+    }
+
+   private:
+    const std::string path_;
+    const std::vector<size_t> primes_;
+    std::unordered_map<size_t, uint32_t> indices_;
+    std::vector<Relation> relations_;
+    std::vector<std::vector<long_int>> progress_;
+    std::unordered_set<long_int> values_;
+    std::mutex mutex_;
+    std::vector<char> buffer_;
+    size_t buffered_;
+    std::ofstream file_;
+};
+
+};  // namespace lpn
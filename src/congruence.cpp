@@ -1,6 +1,11 @@
 #include "congruence.hpp"
 
+#include "thread_group.hpp"
+
+#include <bit>
+#include <cassert>
 #include <climits>
+#include <cmath>
 #include <random>
 
 namespace lpn
@@ -41,6 +46,29 @@ int ComputeLegendreSymbol(long_int n, long_int p)
     return legendre;
 }
 
+static uint64_t PowWithMod(uint64_t a, uint64_t b, uint64_t m)
+{
+    // m < 2^32, so the products fit into 64 bits
+    uint64_t result = 1;
+    a %= m;
+    for (; b > 0; b >>= 1)
+    {
+        if (b & 1)
+        {
+            result = result * a % m;
+        }
+        a = a * a % m;
+    }
+    return result;
+}
+
+int ComputeLegendreSymbol(uint64_t n, uint64_t p)
+{
+    assert(p % 2 == 1 && p <= UINT32_MAX);
+    uint64_t euler = PowWithMod(n, (p - 1) / 2, p);
+    return euler == 0 ? 0 : (euler == 1 ? 1 : -1);
+}
+
 long_int QuadraticCongruences::Solve(const long_int & n, const long_int & p)
 {
     assert(p % 2 != 0);
@@ -61,6 +89,51 @@ long_int QuadraticCongruences::Solve(const long_int & n, const long_int & p)
     return (SolveCongruence(n, h, p) * (p + 1) / 2) % p;
 }
 
+uint64_t QuadraticCongruences::Solve(uint64_t n, uint64_t p)
+{
+    assert(p % 2 == 1 && p <= UINT32_MAX);
+    n %= p;
+    if (n == 0)
+    {
+        return 0;
+    }
+    if (p % 4 == 3)
+    {
+        return PowWithMod(n, (p + 1) / 4, p);
+    }
+
+    // p - 1 = q * 2^s, z is a non-residue
+    size_t s = std::countr_zero(p - 1);
+    uint64_t q = (p - 1) >> s;
+    uint64_t z = 2;
+    while (ComputeLegendreSymbol(z, p) != -1)
+    {
+        ++z;
+    }
+    uint64_t c = PowWithMod(z, q, p);
+    uint64_t t = PowWithMod(n, q, p);
+    uint64_t root = PowWithMod(n, (q + 1) / 2, p);
+    while (t != 1)
+    {
+        // the least i with t^(2^i) = 1
+        size_t i = 0;
+        for (uint64_t square = t; square != 1; square = square * square % p)
+        {
+            ++i;
+        }
+        uint64_t b = c;
+        for (size_t j = i + 1; j < s; ++j)
+        {
+            b = b * b % p;
+        }
+        s = i;
+        c = b * b % p;
+        t = t * c % p;
+        root = root * b % p;
+    }
+    return root;
+}
+
 long_int QuadraticCongruences::FindStartValue(const long_int & n, const long_int & p)
 {
     static std::mt19937 gen{42};
@@ -103,17 +176,83 @@ bool IsQuadraticResidue(const long_int & n, const long_int & p) { return Compute
 
 std::vector<size_t> FindQuadraticResiduePrimes(const long_int & n, size_t factor_size)
 {
-    std::vector<size_t> primes(factor_size + 1);
-    primes[0] = 2;
-    for (size_t p = 3, i = 1; i <= factor_size; p += 2)
+    // the odd primes dividing n are in the factor base with the root 0, they are left out and replaced by the next ones
+    size_t size = factor_size + 1;
+    while (true)
     {
-        if (IsPrimeBasic(p) && IsQuadraticResidue(n, p))
+        FactorBase base = ComputeFactorBase(n, size);
+        std::vector<size_t> primes = {2};
+        for (size_t i = 1; i < base.primes.size(); ++i)
+        {
+            if (base.roots[i] != 0)
+            {
+                primes.push_back(base.primes[i]);
+            }
+        }
+        if (primes.size() == factor_size + 1)
+        {
+            return primes;
+        }
+        size += factor_size + 1 - primes.size();
+    }
+}
+
+FactorBase ComputeFactorBase(const long_int & n, size_t size)
+{
+    constexpr size_t kMinThreadPrimes = 16'384;
+
+    FactorBase base;
+    base.primes.push_back(2);
+    base.roots.push_back(uint32_t(n % 2));
+    // about every second prime gets into the base, so twice the bound of the first 2 * size primes is enough at once
+    double amount = 2.0 * double(size) + 16;
+    size_t begin = 3;
+    size_t end = size_t(amount * (std::log(amount) + std::log(std::log(amount)))) + 16;
+    while (base.primes.size() < size)
+    {
+        std::vector<size_t> primes = SievePrimes(begin, end);
+        std::vector<uint32_t> roots(primes.size());
+        std::vector<uint8_t> residues(primes.size());
+        // n is reduced once per prime, the rest runs in machine words
+        auto compute = [&n, &primes, &roots, &residues](size_t left, size_t right)
+        {
+            for (size_t i = left; i < right; ++i)
+            {
+                uint64_t p = primes[i];
+                uint64_t n_mod = uint64_t(n % p);
+                residues[i] = n_mod == 0 || ComputeLegendreSymbol(n_mod, p) == 1;
+                roots[i] = residues[i] ? uint32_t(QuadraticCongruences::Solve(n_mod, p)) : 0;
+            }
+        };
+        size_t threads = std::min<size_t>(ThreadGroup::GetThreadAmount(), primes.size() / kMinThreadPrimes);
+        if (threads <= 1)
+        {
+            compute(0, primes.size());
+        }
+        else
+        {
+            size_t step = (primes.size() + threads - 1) / threads;
+            ThreadGroup group;
+            for (size_t left = 0; left < primes.size(); left += step)
+            {
+                size_t right = std::min(left + step, primes.size());
+                group.AddTask([&compute, left, right]() { compute(left, right); });
+            }
+            group.ComputeAllTasks();
+        }
+
+        for (size_t i = 0; i < primes.size() && base.primes.size() < size; ++i)
         {
-            primes[i] = p;
-            i += 1;
+            if (residues[i])
+            {
+                base.primes.push_back(primes[i]);
+                base.roots.push_back(roots[i]);
+            }
         }
+        begin = end;
+        end *= 2;
     }
-    return primes;
+    return base;
 }
 
 };  // namespace lpn
@@ -6,13 +6,28 @@ namespace lpn
 {
 
 int ComputeLegendreSymbol(long_int n, long_int p);
+// machine word version for odd primes below 2^32
+int ComputeLegendreSymbol(uint64_t n, uint64_t p);
 bool IsQuadraticResidue(const long_int & n, const long_int & p);
+// 2 and the first factor_size odd primes p with (n / p) = 1
 std::vector<size_t> FindQuadraticResiduePrimes(const long_int & n, size_t factor_size);
 
+// The first primes p for which n is a square modulo p (2, the odd primes with (n / p) = 1 and the odd primes dividing
+// n) and a root of n modulo every p
+struct FactorBase
+{
+    std::vector<size_t> primes;
+    std::vector<uint32_t> roots;
+};
+
+FactorBase ComputeFactorBase(const long_int & n, size_t size);
+
 class QuadraticCongruences
 {
    public:
     static long_int Solve(const long_int & n, const long_int & p);
+    // Tonelli-Shanks in machine words for odd primes below 2^32
+    static uint64_t Solve(uint64_t n, uint64_t p);
 
    private:
     static long_int SolveCongruence(const long_int & n, const long_int & h, const long_int & p);
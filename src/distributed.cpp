@@ -0,0 +1,199 @@
+#include "distributed.hpp"
+#include "checkpoint.hpp"
+#include "partial.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unordered_set>
+
+namespace lpn
+{
+
+using Config = Sieve::Config;
+
+void DistributedSieve::RunWorker(const Config & config, const std::string & directory, size_t worker, size_t workers)
+{
+    assert(config.self_initializing_ && worker < workers);
+    Config worker_config = config;
+    worker_config.multi_thread_ = false;
+    // the relations are reduced by the coordinator, a worker only collects them
+    worker_config.linear_solver_ = LinearSolver::kGaussian;
+    worker_config.SetCheckpoint(GetRelationPath(directory, worker));
+
+    std::string done = GetDonePath(directory, worker);
+    std::filesystem::remove(done);
+    std::string stop = GetStopPath(directory);
+    // a stop file of an earlier run, the coordinator of this one may not have removed it yet
+    FileTime start = GetWriteTime(stop);
+
+    SelfInitializingSieve sieve(config.n_, worker_config);
+    RelationCollector collector(config.n_, worker_config);
+    // the relations of the A up to the last mark are in the file, the A after it are sieved again
+    size_t resume = 0;
+    for (const auto & progress : collector.GetProgress())
+    {
+        if (!progress.empty())
+        {
+            resume = std::max(resume, size_t(progress[0]) + 1);
+        }
+    }
+    for (size_t index = 0; !collector.IsComplete() && sieve.ChooseA(); ++index)
+    {
+        if (index % workers != worker || index < resume)
+        {
+            continue;
+        }
+        if (IsWritten(stop, start))
+        {
+            break;
+        }
+        sieve.SievePolynomials(collector);
+        // the coordinator sees the relations of every A without waiting for a full write buffer, the marks also show
+        // that the worker is alive
+        collector.AddProgress({long_int(index)});
+    }
+    collector.TakeSolution();
+    std::ofstream{done};
+}
+
+std::optional<Solution> DistributedSieve::RunCoordinator(const long_int & n, const Config & config,
+                                                         const std::string & directory, size_t workers,
+                                                         std::chrono::milliseconds timeout)
+{
+    assert(config.n_ == config.multiplier_ * n);
+    Solution solution(config.primes_);
+    PartialRelations partials(config.n_);
+    std::unordered_set<long_int> values;
+    std::vector<size_t> offsets(workers, 0);
+    size_t target = 1.1 * config.factor_size_;
+    size_t relations = 0;
+    std::unique_ptr<IncrementalSolver> incremental;
+    if (config.linear_solver_ == LinearSolver::kIncremental)
+    {
+        incremental = std::make_unique<IncrementalSolver>(n, config.primes_.size());
+    }
+
+    // the stop and done files of an earlier run
+    std::filesystem::remove(GetStopPath(directory));
+    std::vector<FileTime> starts;
+    for (size_t worker = 0; worker < workers; ++worker)
+    {
+        starts.push_back(GetWriteTime(GetDonePath(directory, worker)));
+    }
+    auto last_growth = std::chrono::steady_clock::now();
+
+    bool complete = false;
+    while (!complete)
+    {
+        // checked before the files are read, so that the last records of the finished workers are not missed
+        bool finished = true;
+        for (size_t worker = 0; worker < workers; ++worker)
+        {
+            finished = finished && IsWritten(GetDonePath(directory, worker), starts[worker]);
+        }
+
+        for (size_t worker = 0; worker < workers && relations < target; ++worker)
+        {
+            std::vector<RelationFile::Relation> found;
+            std::vector<std::vector<long_int>> progress;
+            size_t offset = RelationFile::Read(GetRelationPath(directory, worker), config.n_, config.primes_,
+                                               offsets[worker], found, progress);
+            if (offset == 0 || offset == offsets[worker])
+            {
+                continue;
+            }
+            offsets[worker] = offset;
+            last_growth = std::chrono::steady_clock::now();
+            for (auto & relation : found)
+            {
+                if (!values.insert(PartialRelations::ComputeKey(relation.value, config.n_)).second)
+                {
+                    continue;
+                }
+                if (relation.second == 1)
+                {
+                    solution.values.push_back(std::move(relation.value));
+                    solution.factors.Add(relation.factor);
+                    ++relations;
+                }
+                else if (partials.Add(relation.value, std::move(relation.factor), relation.first, relation.second,
+                                      solution))
+                {
+                    ++relations;
+                }
+            }
+        }
+        complete = relations >= target || (incremental && incremental->Update(solution));
+
+        if (!complete && (finished || std::chrono::steady_clock::now() - last_growth > timeout))
+        {
+            break;
+        }
+        if (!complete)
+        {
+            std::this_thread::sleep_for(kPollInterval);
+        }
+    }
+
+    std::ofstream(GetStopPath(directory));
+    if (!complete)
+    {
+        return std::nullopt;
+    }
+    return solution;
+}
+
+std::string DistributedSieve::GetRelationPath(const std::string & directory, size_t worker)
+{
+    return (std::filesystem::path(directory) / ("relations." + std::to_string(worker) + ".bin")).string();
+}
+
+std::string DistributedSieve::GetDonePath(const std::string & directory, size_t worker)
+{
+    return (std::filesystem::path(directory) / ("done." + std::to_string(worker))).string();
+}
+
+std::string DistributedSieve::GetStopPath(const std::string & directory)
+{
+    return (std::filesystem::path(directory) / "stop").string();
+}
+
+DistributedSieve::FileTime DistributedSieve::GetWriteTime(const std::string & path)
+{
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(path, error);
+    if (error)
+    {
+        return std::nullopt;
+    }
+    return time;
+}
+
+bool DistributedSieve::IsWritten(const std::string & path, const FileTime & start)
+{
+    FileTime time = GetWriteTime(path);
+    return time.has_value() && time != start;
+}
+
+FactorSet DistributedFactorization::Factorize(const long_int & n, const Sieve::Config & config,
+                                              const std::string & directory, size_t workers,
+                                              std::chrono::milliseconds timeout)
+{
+    auto collected = DistributedSieve::RunCoordinator(n, config, directory, workers, timeout);
+    if (!collected.has_value())
+    {
+        return FactorSet{{n, 1}};
+    }
+    Solution & solution = collected.value();
+    if (!solution.factor.empty())
+    {
+        return solution.factor;
+    }
+    auto null_space = SolveLinearSystem(solution, config.linear_solver_, config.multi_thread_);
+    return FindFactor(solution, null_space, n, config.multi_thread_);
+}
+
+};  // namespace lpn
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "base.hpp"
+#include "qs.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace lpn
+{
+
+// Self-initializing sieve split over processes which share a directory. Every worker walks the same sequence of A
+// (the generator has a fixed seed), sieves the values of A whose index equals its number modulo the amount of workers
+// and appends the relations to its own relation file, with a progress mark after every A. The coordinator reads the
+// complete records of these files as they grow, drops the relations found twice, combines the partial relations and
+// writes a stop file once there are enough relations. A worker that finishes on its own (the sequence of A ends)
+// leaves a done file.
+// A directory of an earlier run can be reused: a restarted worker skips the A up to its last progress mark, and the
+// stop and done files written before a process started are ignored by it. The collection fails when the workers are
+// done, or no relation file grows for the timeout, before there are enough relations.
+class DistributedSieve
+{
+   private:
+    using Config = Sieve::Config;
+    using FileTime = std::optional<std::filesystem::file_time_type>;
+
+    static constexpr std::chrono::milliseconds kPollInterval{50};
+
+   public:
+    static constexpr std::chrono::milliseconds kStallTimeout{std::chrono::minutes(10)};
+
+    static void RunWorker(const Config & config, const std::string & directory, size_t worker, size_t workers);
+    // std::nullopt when the workers stop or stall with too few relations
+    static std::optional<Solution> RunCoordinator(const long_int & n, const Config & config,
+                                                  const std::string & directory, size_t workers,
+                                                  std::chrono::milliseconds timeout = kStallTimeout);
+
+   private:
+    static std::string GetRelationPath(const std::string & directory, size_t worker);
+    static std::string GetDonePath(const std::string & directory, size_t worker);
+    static std::string GetStopPath(const std::string & directory);
+
+    static FileTime GetWriteTime(const std::string & path);
+    // the file exists and was written after the time seen at the start
+    static bool IsWritten(const std::string & path, const FileTime & start);
+};
+
+class DistributedFactorization : private FactorizationBase
+{
+   public:
+    // the workers are started separately, each as DistributedSieve::RunWorker with the same config and directory;
+    // n itself when the relations could not be collected
+    static FactorSet Factorize(const long_int & n, const Sieve::Config & config, const std::string & directory,
+                               size_t workers, std::chrono::milliseconds timeout = DistributedSieve::kStallTimeout);
+};
+
+};  // namespace lpn
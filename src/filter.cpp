@@ -0,0 +1,329 @@
+#include "filter.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <numeric>
+#include <unordered_set>
+
+namespace lpn
+{
+
+RelationFilter::RelationFilter(const Solution & solution)
+    : relations_(solution.values.size()), rows_(solution.primes.size() + 1)
+{
+    RemoveDuplicates(solution);
+    ComputeWeights();
+    RemoveSingletons();
+    RemoveCliques();
+    RemoveSingletons();
+    MergeLightRows();
+    RemoveSingletons();
+    CreateFactors(solution.primes);
+}
+
+const Relations & RelationFilter::GetFactors() const { return factors_; }
+
+const std::vector<size_t> & RelationFilter::GetPrimes() const { return primes_; }
+
+RelationFilter::Dependency RelationFilter::Expand(const Dependency & dependency) const
+{
+    // a relation found in an even amount of the groups cancels out
+    Dependency expanded;
+    for (auto position : dependency)
+    {
+        const auto & group = groups_[reduced_[position]];
+        expanded.insert(expanded.end(), group.begin(), group.end());
+    }
+    std::sort(expanded.begin(), expanded.end());
+    Dependency result;
+    for (auto relation : expanded)
+    {
+        if (!result.empty() && result.back() == relation)
+        {
+            result.pop_back();
+        }
+        else
+        {
+            result.push_back(relation);
+        }
+    }
+    return result;
+}
+
+void RelationFilter::RemoveDuplicates(const Solution & solution)
+{
+    assert(solution.factors.GetBaseSize() == solution.primes.size());
+    std::unordered_set<long_int> values;
+    for (size_t i = 0; i < relations_; ++i)
+    {
+        if (!values.insert(solution.values[i]).second)
+        {
+            continue;
+        }
+        // the primes outside of the factor base have even exponents, a repeated index adds up modulo 2
+        std::vector<uint32_t> column;
+        auto indices = solution.factors.GetIndices(i);
+        auto powers = solution.factors.GetPowers(i);
+        for (size_t k = 0; k < indices.size(); ++k)
+        {
+            if (powers[k] % 2 == 0)
+            {
+                continue;
+            }
+            if (indices[k] == Relations::kSign)
+            {
+                column.push_back(uint32_t(rows_ - 1));
+            }
+            else if (indices[k] < rows_ - 1)
+            {
+                column.push_back(indices[k]);
+            }
+        }
+        std::sort(column.begin(), column.end());
+        std::vector<uint32_t> odd;
+        for (size_t k = 0; k < column.size(); ++k)
+        {
+            if (!odd.empty() && odd.back() == column[k])
+            {
+                odd.pop_back();
+            }
+            else
+            {
+                odd.push_back(column[k]);
+            }
+        }
+        columns_.push_back(std::move(odd));
+        groups_.push_back({uint32_t(i)});
+    }
+    active_.assign(columns_.size(), true);
+}
+
+void RelationFilter::ComputeWeights()
+{
+    weights_.assign(rows_, 0);
+    for (size_t c = 0; c < columns_.size(); ++c)
+    {
+        for (auto row : columns_[c])
+        {
+            weights_[row] += active_[c];
+        }
+    }
+}
+
+void RelationFilter::RemoveSingletons()
+{
+    // a removal can leave another prime in a single relation, so the passes go on until nothing changes
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t c = 0; c < columns_.size(); ++c)
+        {
+            if (active_[c] && std::any_of(columns_[c].begin(), columns_[c].end(),
+                                          [this](uint32_t row) { return weights_[row] == 1; }))
+            {
+                Deactivate(c);
+                changed = true;
+            }
+        }
+    }
+}
+
+void RelationFilter::RemoveCliques()
+{
+    size_t excess = CountExcess();
+    if (excess <= BasicConfig::kMaxExcess)
+    {
+        return;
+    }
+
+    std::vector<uint32_t> parents(columns_.size());
+    std::iota(parents.begin(), parents.end(), 0);
+    auto find_root = [&parents](uint32_t c)
+    {
+        while (parents[c] != c)
+        {
+            parents[c] = parents[parents[c]];
+            c = parents[c];
+        }
+        return c;
+    };
+    std::vector<uint32_t> first(rows_, UINT32_MAX);
+    for (size_t c = 0; c < columns_.size(); ++c)
+    {
+        for (auto row : columns_[c])
+        {
+            if (!active_[c] || weights_[row] != 2)
+            {
+                continue;
+            }
+            if (first[row] == UINT32_MAX)
+            {
+                first[row] = c;
+            }
+            else
+            {
+                parents[find_root(c)] = find_root(first[row]);
+            }
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> cliques(columns_.size());
+    for (size_t c = 0; c < columns_.size(); ++c)
+    {
+        if (active_[c])
+        {
+            cliques[find_root(c)].push_back(c);
+        }
+    }
+    std::sort(cliques.begin(), cliques.end(),
+              [](const auto & lhs, const auto & rhs) { return lhs.size() > rhs.size(); });
+    for (const auto & clique : cliques)
+    {
+        if (excess <= BasicConfig::kMaxExcess || clique.empty())
+        {
+            break;
+        }
+        for (auto c : clique)
+        {
+            // a relation less, and a prime less for every prime left in no relation
+            excess += Deactivate(c);
+            --excess;
+        }
+    }
+}
+
+void RelationFilter::MergeLightRows()
+{
+    std::vector<std::vector<uint32_t>> row_columns(rows_);
+    std::vector<uint32_t> pending;
+    for (size_t c = 0; c < columns_.size(); ++c)
+    {
+        for (auto row : columns_[c])
+        {
+            if (active_[c])
+            {
+                row_columns[row].push_back(c);
+            }
+        }
+    }
+    for (size_t row = 0; row < rows_; ++row)
+    {
+        if (weights_[row] >= 2 && weights_[row] <= BasicConfig::kMaxMergeWeight)
+        {
+            pending.push_back(row);
+        }
+    }
+
+    while (!pending.empty())
+    {
+        uint32_t row = pending.back();
+        pending.pop_back();
+        if (weights_[row] < 2 || weights_[row] > BasicConfig::kMaxMergeWeight)
+        {
+            continue;
+        }
+        // the lists of the rows keep the relations that lost the row to earlier merges, they are dropped here
+        auto & columns = row_columns[row];
+        std::sort(columns.begin(), columns.end());
+        columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+        std::erase_if(columns, [this, row](uint32_t c)
+                      { return !active_[c] || !std::binary_search(columns_[c].begin(), columns_[c].end(), row); });
+        assert(columns.size() == weights_[row]);
+        uint32_t pivot = *std::min_element(columns.begin(), columns.end(), [this](uint32_t lhs, uint32_t rhs)
+                                           { return columns_[lhs].size() < columns_[rhs].size(); });
+        if (columns_[pivot].size() > BasicConfig::kMaxPivotWeight)
+        {
+            continue;
+        }
+
+        for (auto c : columns)
+        {
+            if (c == pivot)
+            {
+                continue;
+            }
+            for (auto other : columns_[pivot])
+            {
+                if (std::binary_search(columns_[c].begin(), columns_[c].end(), other))
+                {
+                    --weights_[other];
+                }
+                else
+                {
+                    ++weights_[other];
+                    row_columns[other].push_back(c);
+                }
+            }
+            AddSorted(columns_[c], columns_[pivot]);
+            AddSorted(groups_[c], groups_[pivot]);
+        }
+        Deactivate(pivot);
+        for (auto other : columns_[pivot])
+        {
+            if (weights_[other] >= 2 && weights_[other] <= BasicConfig::kMaxMergeWeight)
+            {
+                pending.push_back(other);
+            }
+        }
+    }
+}
+
+size_t RelationFilter::Deactivate(size_t column)
+{
+    size_t emptied = 0;
+    active_[column] = false;
+    for (auto row : columns_[column])
+    {
+        emptied += --weights_[row] == 0;
+    }
+    return emptied;
+}
+
+size_t RelationFilter::CountExcess() const
+{
+    size_t columns = std::count(active_.begin(), active_.end(), true);
+    size_t rows = rows_ - std::count(weights_.begin(), weights_.end(), 0);
+    return columns > rows ? columns - rows : 0;
+}
+
+void RelationFilter::CreateFactors(const std::vector<size_t> & primes)
+{
+    // the rows that are left are numbered again, the sign keeps its own index
+    std::vector<uint32_t> indices(rows_, Relations::kSign);
+    for (size_t row = 0; row + 1 < rows_; ++row)
+    {
+        if (weights_[row] > 0)
+        {
+            indices[row] = uint32_t(primes_.size());
+            primes_.push_back(primes[row]);
+        }
+    }
+    factors_ = Relations(primes_);
+    std::vector<uint32_t> factor;
+    for (size_t c = 0; c < columns_.size(); ++c)
+    {
+        if (!active_[c])
+        {
+            continue;
+        }
+        reduced_.push_back(uint32_t(c));
+        factor.clear();
+        for (auto row : columns_[c])
+        {
+            factor.push_back(indices[row]);
+        }
+        factors_.Add(factor);
+    }
+}
+
+void RelationFilter::AddSorted(std::vector<uint32_t> & lhs, const std::vector<uint32_t> & rhs)
+{
+    std::vector<uint32_t> sum;
+    sum.reserve(lhs.size() + rhs.size());
+    std::set_symmetric_difference(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(sum));
+    lhs = std::move(sum);
+}
+
+};  // namespace lpn
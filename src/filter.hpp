@@ -0,0 +1,65 @@
+#pragma once
+
+#include "base.hpp"
+
+namespace lpn
+{
+
+// Filtering of the relations before the linear algebra. Relations with a value seen before are dropped, then the
+// relations with a prime of odd exponent found in no other relation (they are in no dependency) until none is left.
+// An excess of relations over primes beyond kMaxExcess is pruned by removing the largest cliques (relations joined by
+// primes found in exactly two of them), and the primes found in at most kMaxMergeWeight relations are eliminated by
+// adding the lightest of these relations to the others. Every reduced relation is a sum of original relations, so the
+// dependencies between the reduced relations expand into dependencies between the original ones.
+class RelationFilter
+{
+   private:
+    using Dependency = GaussianBasic::Dependency;
+
+    struct BasicConfig
+    {
+        static constexpr size_t kMaxExcess = 200;
+        static constexpr size_t kMaxMergeWeight = 8;
+        // relations above this amount of primes are not added to others by the merges
+        static constexpr size_t kMaxPivotWeight = 64;
+    };
+
+   public:
+    explicit RelationFilter(const Solution & solution);
+
+    // reduced relations with the exponents taken modulo 2, over the primes that are left
+    const Relations & GetFactors() const;
+    const std::vector<size_t> & GetPrimes() const;
+
+    // a dependency between the reduced relations as a dependency between the relations of the solution, empty when
+    // the groups of the reduced relations cancel out
+    Dependency Expand(const Dependency & dependency) const;
+
+   private:
+    void RemoveDuplicates(const Solution & solution);
+    void ComputeWeights();
+    void RemoveSingletons();
+    void RemoveCliques();
+    void MergeLightRows();
+    // the amount of rows left without relations
+    size_t Deactivate(size_t column);
+    size_t CountExcess() const;
+    void CreateFactors(const std::vector<size_t> & primes);
+
+    static void AddSorted(std::vector<uint32_t> & lhs, const std::vector<uint32_t> & rhs);
+
+   private:
+    size_t relations_;
+    // a row per prime of the factor base and the last one for the sign
+    size_t rows_;
+    // odd rows and original relations of every reduced relation, both sorted
+    std::vector<std::vector<uint32_t>> columns_;
+    std::vector<std::vector<uint32_t>> groups_;
+    std::vector<bool> active_;
+    std::vector<uint32_t> weights_;
+    std::vector<uint32_t> reduced_;
+    Relations factors_;
+    std::vector<size_t> primes_;
+};
+
+};  // namespace lpn
@@ -1,78 +1,362 @@
 #include "gaussian.hpp"
+#include "thread_group.hpp"
+#include "work_stealing_pool.hpp"
 #include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace lpn
 {
-GaussianBasic::Line::Line(size_t n, size_t m) : participants(n), mask(m) {}
+GaussianBasic::GaussianBasic(const FactorSets & factors, const std::vector<size_t> & primes, bool multi_thread)
+    : GaussianBasic(Relations(primes, factors), multi_thread)
+{
+}
 
-GaussianBasic::Line & GaussianBasic::Line::operator^=(Line & line)
+GaussianBasic::GaussianBasic(const Relations & relations, bool multi_thread)
+    : m_(relations.GetBaseSize() + 1),
+      n_(relations.Size()),
+      multi_thread_(multi_thread),
+      stride_(((n_ + 63) / 64 + kAlignWords - 1) / kAlignWords * kAlignWords),
+      rows_(Allocate(m_ * stride_)),
+      tables_(Allocate(kBlockStrips * (size_t(1) << kStripWidth) * stride_)),
+      pivot_columns_(n_)
 {
-    mask ^= line.mask;
-    participants ^= line.participants;
-    return *this;
+    CreateMatrix(relations);
 }
 
-bool GaussianBasic::Line::IsMaskEmpty() const { return mask.none(); }
+void GaussianBasic::CreateMatrix(const Relations & relations)
+{
+    // the exponents are added modulo 2, an index may repeat
+    for (size_t i = 0; i < n_; ++i)
+    {
+        auto indices = relations.GetIndices(i);
+        auto powers = relations.GetPowers(i);
+        for (size_t k = 0; k < indices.size(); ++k)
+        {
+            if (powers[k] % 2 == 0 || (indices[k] != Relations::kSign && indices[k] >= relations.GetBaseSize()))
+            {
+                continue;
+            }
+            size_t row = indices[k] == Relations::kSign ? m_ - 1 : indices[k];
+            GetRow(row)[i / 64] ^= uint64_t(1) << (i % 64);
+        }
+    }
+}
 
-GaussianBasic::GaussianBasic(const FactorSets & factors, const std::vector<size_t> & primes)
-    : n_(factors.size()), m_(primes.size()), matrix_(CreateMatrix(factors, primes))
+size_t GaussianBasic::Solve()
 {
+    // rows before rank are the pivot rows, the rows from rank are zero in all the columns of the previous strips
+    std::vector<size_t> pivots;
+    size_t rank = 0;
+    size_t threads = multi_thread_ ? ThreadGroup::GetThreadAmount() : 1;
+    size_t workers = std::max<size_t>(1, std::min<size_t>(threads, m_ / kMinThreadRows));
+    std::unique_ptr<WorkStealingPool> pool;
+    if (workers > 1)
+    {
+        pool = std::make_unique<WorkStealingPool>(workers);
+    }
+    size_t step = (m_ + workers * kChunksPerWorker - 1) / (workers * kChunksPerWorker);
+
+    for (size_t column = 0; column < n_ && rank < m_; column += kBlockWidth)
+    {
+        size_t found = FindPivots(column, rank, pivots);
+        if (found == 0)
+        {
+            continue;
+        }
+        for (auto pivot : pivots)
+        {
+            pivots_.push_back(pivot);
+            pivot_columns_[pivot] = true;
+        }
+        BuildTables(column, rank, pivots);
+        if (!pool)
+        {
+            EliminateBlock(column, rank, found, 0, m_);
+        }
+        else
+        {
+            for (size_t left = 0; left < m_; left += step)
+            {
+                size_t right = std::min(left + step, m_);
+                pool->AddTask([this, column, rank, found, left, right](size_t)
+                              { EliminateBlock(column, rank, found, left, right); });
+            }
+            pool->Wait();
+        }
+        rank += found;
+    }
+    return n_ - rank;
 }
 
-GaussianBasic::Matrix GaussianBasic::CreateMatrix(const FactorSets & factors, const std::vector<size_t> & primes)
+std::optional<GaussianBasic::Dependency> GaussianBasic::NextDependency()
 {
-    size_t n = factors.size();
-    size_t m = primes.size();
+    for (; next_column_ < n_ && pivot_columns_[next_column_]; ++next_column_)
+    {
+    }
+    if (next_column_ == n_)
+    {
+        return std::nullopt;
+    }
+    // the reduced rows are zero on the other columns without a pivot, so the relation of the column is the sum of the
+    // pivot relations of the rows that have it
+    Dependency dependency = {next_column_};
+    for (size_t row = 0; row < pivots_.size(); ++row)
+    {
+        if (GetBit(row, next_column_))
+        {
+            dependency.push_back(pivots_[row]);
+        }
+    }
+    ++next_column_;
+    std::sort(dependency.begin(), dependency.end());
+    return dependency;
+}
+
+size_t GaussianBasic::FindPivots(size_t column, size_t rank, std::vector<size_t> & pivots)
+{
+    pivots.clear();
+    size_t end = std::min(column + kBlockWidth, n_);
+    for (size_t c = column; c < end; ++c)
+    {
+        size_t pivot_row = rank + pivots.size();
+        for (size_t row = pivot_row; row < m_; ++row)
+        {
+            // the columns of the pivots found before are cleared first, then the row either has the column or not
+            for (size_t k = 0; k < pivots.size(); ++k)
+            {
+                if (GetBit(row, pivots[k]))
+                {
+                    AddRow(row, rank + k, column);
+                }
+            }
+            if (GetBit(row, c))
+            {
+                std::swap_ranges(GetRow(row), GetRow(row) + stride_, GetRow(pivot_row));
+                pivots.push_back(c);
+                break;
+            }
+        }
+    }
 
-    Matrix matrix = Matrix(n);
-    for (size_t i = 0; i < n; ++i)
+    // the pivot rows are reduced to the identity on the pivot columns
+    for (size_t i = pivots.size(); i-- > 0;)
     {
-        matrix[i] = Line(n, m);
-        for (size_t j = 0; j < m; ++j)
+        for (size_t k = 0; k < i; ++k)
         {
-            auto iter = factors[i].find(primes[j]);
-            if (iter != factors[i].end() && iter->second % 2 == 1)
+            if (GetBit(rank + k, pivots[i]))
             {
-                matrix[i].mask[j] = true;
+                AddRow(rank + k, rank + i, column);
             }
         }
-        matrix[i].participants[i] = true;
     }
-    return matrix;
+    return pivots.size();
 }
 
-size_t GaussianBasic::FindFirstNonZeroInLine(size_t line_pos) const
+void GaussianBasic::BuildTables(size_t column, size_t rank, const std::vector<size_t> & pivots)
 {
-    size_t col = matrix_[line_pos].mask.find_first();
-    if (col == std::string::npos)
+    // the pivot rows are the identity on the pivot columns of the block, so the tables of the strips do not touch
+    // the pivot columns of each other and the entries of a row are all taken from its bits before the block
+    size_t first = column / 64 / kAlignWords * kAlignWords;
+    size_t words = stride_ - first;
+    for (size_t strip = 0; strip < kBlockStrips; ++strip)
     {
-        return m_;
+        std::vector<size_t> rows;
+        entries_[strip].fill(0);
+        for (size_t k = 0; k < pivots.size(); ++k)
+        {
+            size_t offset = pivots[k] - column;
+            if (offset / kStripWidth != strip)
+            {
+                continue;
+            }
+            for (size_t byte = 0; byte < 256; ++byte)
+            {
+                entries_[strip][byte] |= ((byte >> (offset % kStripWidth)) & 1) << rows.size();
+            }
+            rows.push_back(rank + k);
+        }
+
+        // the entry s is the sum of the pivot rows of the bits of s, every entry adds one row to a previous one
+        uint64_t * table = tables_.get() + strip * (size_t(1) << kStripWidth) * stride_;
+        std::fill(table + first, table + stride_, 0);
+        for (size_t s = 1; s < (size_t(1) << rows.size()); ++s)
+        {
+            uint64_t * entry = table + s * stride_ + first;
+            const uint64_t * previous = table + (s & (s - 1)) * stride_ + first;
+            std::copy(previous, previous + words, entry);
+            XorWords(entry, GetRow(rows[std::countr_zero(s)]) + first, words);
+        }
     }
-    return col;
 }
 
-GaussianBasic::Matrix GaussianBasic::Solve()
+void GaussianBasic::EliminateBlock(size_t column, size_t rank, size_t found, size_t begin, size_t end)
 {
-    for (size_t i = 0; i < n_; ++i)
+    // a block never crosses a word
+    size_t first = column / 64 / kAlignWords * kAlignWords;
+    size_t words = stride_ - first;
+    std::array<const uint64_t *, kBlockStrips> sources;
+    for (size_t row = begin; row < end; ++row)
     {
-        size_t col = FindFirstNonZeroInLine(i);
-        if (col != m_)
+        if (row >= rank && row < rank + found)
         {
-            AddToAll(col, i);
+            continue;
+        }
+        uint64_t * data = GetRow(row);
+        uint64_t bits = data[column / 64] >> (column % 64);
+        size_t count = 0;
+        for (size_t strip = 0; strip < kBlockStrips; ++strip, bits >>= kStripWidth)
+        {
+            size_t entry = entries_[strip][bits & 0xff];
+            if (entry != 0)
+            {
+                sources[count++] = tables_.get() + (strip << kStripWidth | entry) * stride_ + first;
+            }
+        }
+        if (count != 0)
+        {
+            XorWords(data + first, sources.data(), count, words);
         }
     }
-    return matrix_;
 }
 
-void GaussianBasic::AddToAll(size_t col, size_t line)
+IncrementalGaussian::IncrementalGaussian(size_t base_size)
+    : m_(base_size + 1), mask_words_((m_ + 63) / 64), pivots_(m_, kNoRow), offsets_(1, 0), mask_(mask_words_)
 {
-    for (size_t i = 0; i < n_; ++i)
+}
+
+std::optional<IncrementalGaussian::Dependency> IncrementalGaussian::Add(const Relations & relations, size_t relation)
+{
+    std::fill(mask_.begin(), mask_.end(), 0);
+    auto indices = relations.GetIndices(relation);
+    auto powers = relations.GetPowers(relation);
+    for (size_t k = 0; k < indices.size(); ++k)
+    {
+        if (powers[k] % 2 == 0 || (indices[k] != Relations::kSign && indices[k] >= m_ - 1))
+        {
+            continue;
+        }
+        size_t column = indices[k] == Relations::kSign ? m_ - 1 : indices[k];
+        mask_[column / 64] ^= uint64_t(1) << (column % 64);
+    }
+    combination_.assign(relation / 64 + 1, 0);
+    combination_[relation / 64] = uint64_t(1) << (relation % 64);
+
+    // the bits below the lowest one of a row are zero, so every row clears its pivot and changes only the bits above
+    for (size_t word = 0; word < mask_words_; ++word)
+    {
+        while (mask_[word] != 0)
+        {
+            size_t column = word * 64 + std::countr_zero(mask_[word]);
+            uint32_t row = pivots_[column];
+            if (row == kNoRow)
+            {
+                pivots_[column] = uint32_t(offsets_.size() - 1);
+                masks_.insert(masks_.end(), mask_.begin(), mask_.end());
+                combinations_.insert(combinations_.end(), combination_.begin(), combination_.end());
+                offsets_.push_back(combinations_.size());
+                return std::nullopt;
+            }
+            const uint64_t * mask = masks_.data() + row * mask_words_;
+            for (size_t k = word; k < mask_words_; ++k)
+            {
+                mask_[k] ^= mask[k];
+            }
+            for (size_t k = offsets_[row]; k < offsets_[row + 1]; ++k)
+            {
+                combination_[k - offsets_[row]] ^= combinations_[k];
+            }
+        }
+    }
+
+    Dependency dependency;
+    for (size_t word = 0; word < combination_.size(); ++word)
+    {
+        for (uint64_t bits = combination_[word]; bits != 0; bits &= bits - 1)
+        {
+            dependency.push_back(word * 64 + std::countr_zero(bits));
+        }
+    }
+    return dependency;
+}
+
+size_t IncrementalGaussian::GetRank() const { return offsets_.size() - 1; }
+
+uint64_t * GaussianBasic::GetRow(size_t row) const { return rows_.get() + row * stride_; }
+
+bool GaussianBasic::GetBit(size_t row, size_t column) const
+{
+    return (GetRow(row)[column / 64] >> (column % 64)) & 1;
+}
+
+void GaussianBasic::AddRow(size_t to, size_t from, size_t column)
+{
+    // both rows are zero before the strip of the column
+    size_t first = column / 64 / kAlignWords * kAlignWords;
+    XorWords(GetRow(to) + first, GetRow(from) + first, stride_ - first);
+}
+
+GaussianBasic::Words GaussianBasic::Allocate(size_t words)
+{
+    size_t bytes = std::max(words, kAlignWords) * sizeof(uint64_t);
+    auto * data = static_cast<uint64_t *>(std::aligned_alloc(kAlignWords * sizeof(uint64_t), bytes));
+    std::memset(data, 0, bytes);
+    return Words(data);
+}
+
+void GaussianBasic::XorWords(uint64_t * to, const uint64_t * from, size_t words) { XorWords(to, &from, 1, words); }
+
+void GaussianBasic::XorWords(uint64_t * to, const uint64_t * const * sources, size_t count, size_t words)
+{
+    // the row is loaded and stored once for all the sources, the pointers are 64-byte aligned and the amount of words
+    // is a multiple of kAlignWords
+#if defined(__AVX512F__)
+    for (size_t k = 0; k < words; k += 8)
+    {
+        __m512i value = _mm512_load_si512(to + k);
+        for (size_t i = 0; i < count; ++i)
+        {
+            value = _mm512_xor_si512(value, _mm512_load_si512(sources[i] + k));
+        }
+        _mm512_store_si512(to + k, value);
+    }
+#elif defined(__AVX2__)
+    for (size_t k = 0; k < words; k += 4)
+    {
+        auto * lhs = reinterpret_cast<__m256i *>(to + k);
+        __m256i value = _mm256_load_si256(lhs);
+        for (size_t i = 0; i < count; ++i)
+        {
+            value = _mm256_xor_si256(value, _mm256_load_si256(reinterpret_cast<const __m256i *>(sources[i] + k)));
+        }
+        _mm256_store_si256(lhs, value);
+    }
+#elif defined(__SSE2__)
+    for (size_t k = 0; k < words; k += 2)
+    {
+        auto * lhs = reinterpret_cast<__m128i *>(to + k);
+        __m128i value = _mm_load_si128(lhs);
+        for (size_t i = 0; i < count; ++i)
+        {
+            value = _mm_xor_si128(value, _mm_load_si128(reinterpret_cast<const __m128i *>(sources[i] + k)));
+        }
+        _mm_store_si128(lhs, value);
+    }
+#else
+    for (size_t k = 0; k < words; ++k)
     {
-        if (matrix_[i].mask[col] && i != line)
+        uint64_t value = to[k];
+        for (size_t i = 0; i < count; ++i)
         {
-            matrix_[i] ^= matrix_[line];
+            value ^= sources[i][k];
         }
+        to[k] = value;
     }
+#endif
 }
 
 };  // namespace lpn
@@ -1,44 +1,116 @@
 #pragma once
 
-#include <boost/dynamic_bitset.hpp>
 #include "basic.hpp"
+#include "relations.hpp"
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <optional>
 #include <set>
 #include <unordered_set>
 
 namespace lpn
 {
+// Dense Gauss-Jordan elimination over GF(2) of the primes (rows) by the relations (columns). Every row is packed into
+// words, 64-byte aligned, and the columns are eliminated with the Method of Four Russians: the pivot rows of every
+// strip of kStripWidth columns are combined into a table of all their sums, so every other row takes a table lookup
+// and one row XOR per strip. The strips go in blocks of kBlockStrips, a row is read from memory once per block. With
+// multi_thread the rows are updated by a pool of workers in chunks, every row depends only on the tables, so the
+// result is the same as on one thread.
+// The null space is read from the reduced matrix: every column without a pivot gives the dependency of its relation
+// and the pivot relations of the rows that have it, so the dependencies are generated one at a time and the matrix
+// takes a bit per prime and relation.
 class GaussianBasic
 {
-   public:
-    class Line
-    {
-       public:
-        Line() = default;
-        Line(size_t n, size_t m);
-
-        Line & operator^=(Line & line);
-        bool IsMaskEmpty() const;
+   private:
+    static constexpr size_t kStripWidth = 8;
+    static constexpr size_t kBlockStrips = 4;
+    static constexpr size_t kBlockWidth = kStripWidth * kBlockStrips;
+    static constexpr size_t kAlignWords = 8;
+    static constexpr size_t kMinThreadRows = 1024;
+    static constexpr size_t kChunksPerWorker = 4;
 
-        boost::dynamic_bitset<> participants;
-        boost::dynamic_bitset<> mask;
+    struct AlignedFree
+    {
+        void operator()(uint64_t * data) const { std::free(data); }
     };
+    using Words = std::unique_ptr<uint64_t[], AlignedFree>;
 
-    using Matrix = std::vector<Line>;
+   public:
+    // positions of relations with a perfect square product, in increasing order
+    using Dependency = std::vector<size_t>;
 
-    GaussianBasic(const FactorSets & factors, const std::vector<size_t> & primes);
+    // the rows are the factor base of the relations and the sign, the primes outside of the factor base are skipped
+    explicit GaussianBasic(const Relations & relations, bool multi_thread = false);
+    GaussianBasic(const FactorSets & factors, const std::vector<size_t> & primes, bool multi_thread = false);
 
-    Matrix Solve();
+    // the amount of independent dependencies
+    size_t Solve();
+    // nullopt after the last one, Solve comes first
+    std::optional<Dependency> NextDependency();
 
    private:
-    static Matrix CreateMatrix(const FactorSets & factors, const std::vector<size_t> & primes);
+    // the last row is the sign: the factor -1 of a negative relation
+    void CreateMatrix(const Relations & relations);
+
+    size_t FindPivots(size_t column, size_t rank, std::vector<size_t> & pivots);
+    void BuildTables(size_t column, size_t rank, const std::vector<size_t> & pivots);
+    void EliminateBlock(size_t column, size_t rank, size_t found, size_t begin, size_t end);
 
-    size_t FindFirstNonZeroInLine(size_t line_pos) const;
+    uint64_t * GetRow(size_t row) const;
+    bool GetBit(size_t row, size_t column) const;
+    void AddRow(size_t to, size_t from, size_t first_word);
 
-    void AddToAll(size_t col, size_t line);
+    static Words Allocate(size_t words);
+    static void XorWords(uint64_t * to, const uint64_t * from, size_t words);
+    static void XorWords(uint64_t * to, const uint64_t * const * sources, size_t count, size_t words);
 
    private:
     size_t m_;
     size_t n_;
-    Matrix matrix_;
+    bool multi_thread_;
+    // a row is rounded up to kAlignWords
+    size_t stride_;
+    Words rows_;
+    // a table of 256 rows per strip of the block and the map of the bytes of a strip to its rows
+    Words tables_;
+    std::array<std::array<uint8_t, 256>, kBlockStrips> entries_;
+    // the pivot column of every row before the rank, the columns without a pivot are taken from next_column_ on
+    std::vector<size_t> pivots_;
+    std::vector<bool> pivot_columns_;
+    size_t next_column_ = 0;
+};
+
+// Gaussian elimination over GF(2) of the relations one at a time, in the order they are found. A relation is reduced
+// by the rows of the basis from its lowest odd prime up: when that prime has no pivot yet the relation becomes the
+// row of this pivot, when nothing is left it closes a dependency. Every row keeps the relations it is the sum of, a
+// row made at the relation r has none after r, so it takes r / 64 words.
+class IncrementalGaussian
+{
+   private:
+    static constexpr uint32_t kNoRow = UINT32_MAX;
+
+   public:
+    using Dependency = GaussianBasic::Dependency;
+
+    // the columns are the factor base and the sign, the primes outside of the factor base are skipped
+    explicit IncrementalGaussian(size_t base_size);
+
+    // the relations are added in order, nullopt when the relation is independent of the ones before it
+    std::optional<Dependency> Add(const Relations & relations, size_t relation);
+    size_t GetRank() const;
+
+   private:
+    size_t m_;
+    size_t mask_words_;
+    // the row of every pivot column
+    std::vector<uint32_t> pivots_;
+    // masks of the rows, the combinations of the row i are combinations_[offsets_[i] .. offsets_[i + 1])
+    std::vector<uint64_t> masks_;
+    std::vector<uint64_t> combinations_;
+    std::vector<size_t> offsets_;
+    // the mask and the combinations of the relation being reduced
+    std::vector<uint64_t> mask_;
+    std::vector<uint64_t> combination_;
 };
 };  // namespace lpn
@@ -0,0 +1,437 @@
+#include "lanczos.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <random>
+#include <set>
+
+namespace lpn
+{
+
+BlockLanczos::BlockLanczos(const FactorSets & factors, const std::vector<size_t> & primes)
+    : BlockLanczos(Relations(primes, factors))
+{
+}
+
+BlockLanczos::BlockLanczos(const Relations & relations)
+    : rows_(relations.GetBaseSize() + 1), columns_(relations.Size()), offsets_(1, 0)
+{
+    // the last row is the sign, the same as the last column of GaussianBasic; a repeated index adds up modulo 2 in
+    // the products as well
+    for (size_t c = 0; c < columns_; ++c)
+    {
+        auto indices = relations.GetIndices(c);
+        auto powers = relations.GetPowers(c);
+        for (size_t k = 0; k < indices.size(); ++k)
+        {
+            if (powers[k] % 2 == 0)
+            {
+                continue;
+            }
+            if (indices[k] == Relations::kSign)
+            {
+                indices_.push_back(uint32_t(rows_ - 1));
+            }
+            else if (indices[k] < relations.GetBaseSize())
+            {
+                indices_.push_back(indices[k]);
+            }
+        }
+        offsets_.push_back(uint32_t(indices_.size()));
+    }
+}
+
+std::vector<BlockLanczos::Dependency> BlockLanczos::Solve()
+{
+    std::vector<Dependency> dependencies;
+    for (size_t attempt = 0; attempt < kMaxAttempts && dependencies.empty(); ++attempt)
+    {
+        // a breakdown depends on the random start, the next attempt begins elsewhere
+        Iterate(kSeed + attempt, dependencies);
+    }
+    return dependencies;
+}
+
+bool BlockLanczos::Iterate(size_t seed, std::vector<Dependency> & dependencies) const
+{
+    size_t n = columns_;
+    if (n == 0)
+    {
+        return false;
+    }
+    std::mt19937_64 gen(seed);
+    std::vector<uint64_t> y(n);
+    for (auto & word : y)
+    {
+        word = gen();
+    }
+
+    // A x = A y is solved for x, then x - y is in the null space of A
+    std::vector<uint64_t> scratch(rows_);
+    std::array<std::vector<uint64_t>, 3> v = {std::vector<uint64_t>(n), std::vector<uint64_t>(n, 0),
+                                              std::vector<uint64_t>(n, 0)};
+    std::vector<uint64_t> next(n);
+    std::vector<uint64_t> x(n, 0);
+    MultiplyA(y, v[0], scratch);
+    const std::vector<uint64_t> v0 = v[0];
+
+    // index 0 is the current iteration, 1 and 2 are the previous ones
+    std::array<Block, 2> vt_a_v = {};
+    std::array<Block, 2> vt_a2_v = {};
+    std::array<Block, 3> winv = {};
+    std::array<std::array<size_t, 64>, 2> selected = {};
+    for (size_t i = 0; i < 64; ++i)
+    {
+        selected[1][i] = i;
+    }
+    size_t dim1 = 64;
+    uint64_t mask1 = ~uint64_t(0);
+    Block d, e, f, f2, product;
+
+    // every iteration removes about 63 dimensions, the rest is a margin for the final ones
+    size_t max_iterations = n / 32 + 64;
+    bool finished = false;
+    for (size_t iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        MultiplyA(v[0], next, scratch);
+        MultiplyTransposed(v[0], next, vt_a_v[0]);
+        MultiplyTransposed(next, next, vt_a2_v[0]);
+        if (std::all_of(vt_a_v[0].begin(), vt_a_v[0].end(), [](uint64_t row) { return row == 0; }))
+        {
+            finished = true;
+            break;
+        }
+
+        size_t dim0 = FindNonsingular(vt_a_v[0], selected[1], dim1, selected[0], winv[0]);
+        if (dim0 == 0)
+        {
+            return false;
+        }
+        uint64_t mask0 = 0;
+        for (size_t i = 0; i < dim0; ++i)
+        {
+            mask0 |= uint64_t(1) << selected[0][i];
+        }
+
+        // D = I - W^-1 (V^T A^2 V S S^T + V^T A V)
+        for (size_t i = 0; i < 64; ++i)
+        {
+            d[i] = (vt_a2_v[0][i] & mask0) ^ vt_a_v[0][i];
+        }
+        MultiplyBlocks(winv[0], d, product);
+        for (size_t i = 0; i < 64; ++i)
+        {
+            d[i] = product[i] ^ (uint64_t(1) << i);
+        }
+
+        // E = W_1^-1 V^T A V S S^T
+        MultiplyBlocks(winv[1], vt_a_v[0], e);
+        for (size_t i = 0; i < 64; ++i)
+        {
+            e[i] &= mask0;
+        }
+
+        // F = W_2^-1 (I - V_1^T A V_1 W_1^-1) (V_1^T A^2 V_1 S_1 S_1^T + V_1^T A V_1) S S^T
+        MultiplyBlocks(vt_a_v[1], winv[1], product);
+        for (size_t i = 0; i < 64; ++i)
+        {
+            product[i] ^= uint64_t(1) << i;
+        }
+        MultiplyBlocks(winv[2], product, f);
+        for (size_t i = 0; i < 64; ++i)
+        {
+            f2[i] = ((vt_a2_v[1][i] & mask1) ^ vt_a_v[1][i]) & mask0;
+        }
+        MultiplyBlocks(f, f2, product);
+        f = product;
+
+        // V_next = A V S S^T + V D + V_1 E + V_2 F
+        for (auto & word : next)
+        {
+            word &= mask0;
+        }
+        MultiplyBlock(v[0], d, next);
+        MultiplyBlock(v[1], e, next);
+        MultiplyBlock(v[2], f, next);
+
+        // x += V W^-1 V^T v0
+        MultiplyTransposed(v[0], v0, d);
+        MultiplyBlocks(winv[0], d, product);
+        MultiplyBlock(v[0], product, x);
+
+        std::swap(v[2], v[1]);
+        std::swap(v[1], v[0]);
+        std::swap(v[0], next);
+        winv[2] = winv[1];
+        winv[1] = winv[0];
+        vt_a_v[1] = vt_a_v[0];
+        vt_a2_v[1] = vt_a2_v[0];
+        selected[1] = selected[0];
+        mask1 = mask0;
+        dim1 = dim0;
+    }
+    if (!finished)
+    {
+        return false;
+    }
+
+    for (size_t c = 0; c < n; ++c)
+    {
+        x[c] ^= y[c];
+    }
+    CombineVectors(x, v[0], dependencies);
+    return !dependencies.empty();
+}
+
+void BlockLanczos::CombineVectors(const std::vector<uint64_t> & x, const std::vector<uint64_t> & v,
+                                  std::vector<Dependency> & dependencies) const
+{
+    // the 128 vectors of x and v are in the null space of B^T B, so their images under B span a small space and the
+    // combinations with a zero image are found by elimination
+    std::vector<uint64_t> bx(rows_);
+    std::vector<uint64_t> bv(rows_);
+    MultiplyB(x, bx);
+    MultiplyB(v, bv);
+
+    std::vector<boost::dynamic_bitset<>> images(128, boost::dynamic_bitset<>(rows_));
+    std::vector<boost::dynamic_bitset<>> combinations(128, boost::dynamic_bitset<>(128));
+    for (size_t r = 0; r < rows_; ++r)
+    {
+        for (size_t k = 0; k < 64; ++k)
+        {
+            images[k][r] = (bx[r] >> k) & 1;
+            images[k + 64][r] = (bv[r] >> k) & 1;
+        }
+    }
+
+    std::vector<size_t> basis;
+    std::vector<size_t> pivots(128);
+    std::set<boost::dynamic_bitset<>> found;
+    for (size_t k = 0; k < 128; ++k)
+    {
+        combinations[k][k] = true;
+        for (auto b : basis)
+        {
+            if (images[k][pivots[b]])
+            {
+                images[k] ^= images[b];
+                combinations[k] ^= combinations[b];
+            }
+        }
+        if (images[k].any())
+        {
+            pivots[k] = images[k].find_first();
+            basis.push_back(k);
+            continue;
+        }
+
+        uint64_t low = 0, high = 0;
+        for (size_t i = 0; i < 64; ++i)
+        {
+            low |= uint64_t(combinations[k][i]) << i;
+            high |= uint64_t(combinations[k][i + 64]) << i;
+        }
+        boost::dynamic_bitset<> columns(columns_);
+        for (size_t c = 0; c < columns_; ++c)
+        {
+            columns[c] = (std::popcount(x[c] & low) + std::popcount(v[c] & high)) % 2 == 1;
+        }
+        if (columns.any() && IsDependency(columns) && found.insert(columns).second)
+        {
+            Dependency dependency;
+            for (size_t c = columns.find_first(); c != boost::dynamic_bitset<>::npos; c = columns.find_next(c))
+            {
+                dependency.push_back(c);
+            }
+            dependencies.push_back(std::move(dependency));
+        }
+    }
+}
+
+bool BlockLanczos::IsDependency(const boost::dynamic_bitset<> & columns) const
+{
+    boost::dynamic_bitset<> rows(rows_);
+    for (size_t c = columns.find_first(); c != boost::dynamic_bitset<>::npos; c = columns.find_next(c))
+    {
+        for (size_t k = offsets_[c]; k < offsets_[c + 1]; ++k)
+        {
+            rows.flip(indices_[k]);
+        }
+    }
+    return rows.none();
+}
+
+void BlockLanczos::MultiplyB(const std::vector<uint64_t> & x, std::vector<uint64_t> & y) const
+{
+    std::fill(y.begin(), y.end(), 0);
+    for (size_t c = 0; c < columns_; ++c)
+    {
+        for (size_t k = offsets_[c]; k < offsets_[c + 1]; ++k)
+        {
+            y[indices_[k]] ^= x[c];
+        }
+    }
+}
+
+void BlockLanczos::MultiplyA(const std::vector<uint64_t> & x, std::vector<uint64_t> & y,
+                             std::vector<uint64_t> & scratch) const
+{
+    // A = B^T B, the product by B^T gathers the rows of every column
+    MultiplyB(x, scratch);
+    for (size_t c = 0; c < columns_; ++c)
+    {
+        uint64_t word = 0;
+        for (size_t k = offsets_[c]; k < offsets_[c + 1]; ++k)
+        {
+            word ^= scratch[indices_[k]];
+        }
+        y[c] = word;
+    }
+}
+
+void BlockLanczos::MultiplyTransposed(const std::vector<uint64_t> & x, const std::vector<uint64_t> & y, Block & result)
+{
+    // x^T y: the words of y are summed by the bytes of x first, then every byte value is spread over its bits
+    std::vector<uint64_t> sums(8 * 256, 0);
+    for (size_t k = 0; k < x.size(); ++k)
+    {
+        uint64_t word = x[k];
+        for (size_t byte = 0; byte < 8; ++byte, word >>= 8)
+        {
+            sums[256 * byte + (word & 0xff)] ^= y[k];
+        }
+    }
+    result.fill(0);
+    for (size_t byte = 0; byte < 8; ++byte)
+    {
+        for (size_t value = 1; value < 256; ++value)
+        {
+            for (size_t bit = 0; bit < 8; ++bit)
+            {
+                if ((value >> bit) & 1)
+                {
+                    result[8 * byte + bit] ^= sums[256 * byte + value];
+                }
+            }
+        }
+    }
+}
+
+void BlockLanczos::MultiplyBlock(const std::vector<uint64_t> & x, const Block & block, std::vector<uint64_t> & result)
+{
+    // result += x * block, with the sums of the rows of the block precomputed for every byte value
+    std::vector<uint64_t> table(8 * 256, 0);
+    for (size_t byte = 0; byte < 8; ++byte)
+    {
+        for (size_t value = 1; value < 256; ++value)
+        {
+            size_t bit = std::countr_zero(value);
+            table[256 * byte + value] = table[256 * byte + (value & (value - 1))] ^ block[8 * byte + bit];
+        }
+    }
+    for (size_t k = 0; k < x.size(); ++k)
+    {
+        uint64_t word = x[k];
+        uint64_t sum = 0;
+        for (size_t byte = 0; byte < 8; ++byte, word >>= 8)
+        {
+            sum ^= table[256 * byte + (word & 0xff)];
+        }
+        result[k] ^= sum;
+    }
+}
+
+void BlockLanczos::MultiplyBlocks(const Block & lhs, const Block & rhs, Block & result)
+{
+    for (size_t i = 0; i < 64; ++i)
+    {
+        uint64_t row = 0;
+        for (uint64_t bits = lhs[i]; bits != 0; bits &= bits - 1)
+        {
+            row ^= rhs[std::countr_zero(bits)];
+        }
+        result[i] = row;
+    }
+}
+
+size_t BlockLanczos::FindNonsingular(const Block & t, const std::array<size_t, 64> & last, size_t last_size,
+                                     std::array<size_t, 64> & selected, Block & inverse)
+{
+    // Montgomery's choice of the columns S: the columns left out at the previous step come first, then the inverse of
+    // the submatrix of t on S is found by elimination of [t | I]
+    std::array<std::array<uint64_t, 2>, 64> m;
+    for (size_t i = 0; i < 64; ++i)
+    {
+        m[i] = {t[i], uint64_t(1) << i};
+    }
+    uint64_t last_mask = 0;
+    for (size_t i = 0; i < last_size; ++i)
+    {
+        last_mask |= uint64_t(1) << last[i];
+    }
+    std::array<size_t, 64> order;
+    size_t pos = 0;
+    for (size_t i = 0; i < 64; ++i)
+    {
+        if (!((last_mask >> i) & 1))
+        {
+            order[pos++] = i;
+        }
+    }
+    for (size_t i = 0; i < last_size; ++i)
+    {
+        order[pos++] = last[i];
+    }
+
+    size_t dim = 0;
+    for (size_t i = 0; i < 64; ++i)
+    {
+        uint64_t mask = uint64_t(1) << order[i];
+        auto & row_i = m[order[i]];
+        size_t j = i;
+        for (; j < 64 && !(m[order[j]][0] & mask); ++j)
+        {
+        }
+        if (j < 64)
+        {
+            std::swap(row_i, m[order[j]]);
+            for (size_t k = 0; k < 64; ++k)
+            {
+                if (k != i && (m[order[k]][0] & mask))
+                {
+                    m[order[k]][0] ^= row_i[0];
+                    m[order[k]][1] ^= row_i[1];
+                }
+            }
+            selected[dim++] = order[i];
+            continue;
+        }
+
+        // no pivot in t: the column is left out and eliminated from the inverse through the identity half
+        for (j = i; j < 64 && !(m[order[j]][1] & mask); ++j)
+        {
+        }
+        if (j == 64)
+        {
+            return 0;
+        }
+        std::swap(row_i, m[order[j]]);
+        for (size_t k = 0; k < 64; ++k)
+        {
+            if (k != i && (m[order[k]][1] & mask))
+            {
+                m[order[k]][0] ^= row_i[0];
+                m[order[k]][1] ^= row_i[1];
+            }
+        }
+        row_i = {0, 0};
+    }
+
+    for (size_t i = 0; i < 64; ++i)
+    {
+        inverse[i] = m[i][1];
+    }
+    return dim;
+}
+
+};  // namespace lpn
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "gaussian.hpp"
+#include <boost/dynamic_bitset.hpp>
+
+#include <array>
+
+namespace lpn
+{
+
+// Montgomery's Block Lanczos over GF(2) for the sparse relation matrix B (a row per prime and one for the sign, a
+// column per relation). It iterates on A = B^T B with blocks of 64 vectors packed into uint64 words, so the work is
+// about (relations / 64) products by B and B^T and the memory is linear in the number of nonzero entries. The null
+// space vectors are returned as the positions of their relations, the same as GaussianBasic::NextDependency.
+class BlockLanczos
+{
+   private:
+    using Block = std::array<uint64_t, 64>;
+
+    static constexpr size_t kMaxAttempts = 4;
+    static constexpr size_t kSeed = 42;
+
+   public:
+    using Dependency = GaussianBasic::Dependency;
+
+    explicit BlockLanczos(const Relations & relations);
+    BlockLanczos(const FactorSets & factors, const std::vector<size_t> & primes);
+
+    // empty when no dependency is found, e.g. when the matrix is too small for blocks of 64 vectors
+    std::vector<Dependency> Solve();
+
+   private:
+    bool Iterate(size_t seed, std::vector<Dependency> & dependencies) const;
+    void CombineVectors(const std::vector<uint64_t> & x, const std::vector<uint64_t> & v,
+                        std::vector<Dependency> & dependencies) const;
+    bool IsDependency(const boost::dynamic_bitset<> & columns) const;
+
+    void MultiplyB(const std::vector<uint64_t> & x, std::vector<uint64_t> & y) const;
+    void MultiplyA(const std::vector<uint64_t> & x, std::vector<uint64_t> & y, std::vector<uint64_t> & scratch) const;
+
+    static void MultiplyTransposed(const std::vector<uint64_t> & x, const std::vector<uint64_t> & y, Block & result);
+    static void MultiplyBlock(const std::vector<uint64_t> & x, const Block & block, std::vector<uint64_t> & result);
+    static void MultiplyBlocks(const Block & lhs, const Block & rhs, Block & result);
+    static size_t FindNonsingular(const Block & t, const std::array<size_t, 64> & last, size_t last_size,
+                                  std::array<size_t, 64> & selected, Block & inverse);
+
+   private:
+    size_t rows_;
+    size_t columns_;
+    // odd exponents of every relation: rows of column c are indices_[offsets_[c] .. offsets_[c + 1])
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> indices_;
+};
+
+};  // namespace lpn
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "aliases.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <numeric>
+
+namespace lpn
+{
+
+// Arithmetic modulo an odd n below 2^(64 * N) in the Montgomery form x * R mod n with R = 2^(64 * N). The numbers are
+// arrays of N words, least significant first, so a product takes N^2 word multiplications and no allocation.
+template <size_t N>
+class Montgomery
+{
+   public:
+    using Number = std::array<uint64_t, N>;
+
+    explicit Montgomery(const long_int & n) : n_(ToNumber(n)), inverse_(ComputeInverse(n_[0]))
+    {
+        assert(n % 2 == 1 && msb(n) < 64 * N);
+        one_ = ToNumber((long_int(1) << (64 * N)) % n);
+    }
+
+    Number Convert(const long_int & x) const
+    {
+        long_int n = ToLongInt(n_);
+        long_int reduced = x % n;
+        if (reduced < 0)
+        {
+            reduced += n;
+        }
+        return ToNumber((reduced << (64 * N)) % n);
+    }
+
+    const Number & GetOne() const { return one_; }
+
+    Number Add(const Number & a, const Number & b) const
+    {
+        Number sum;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            unsigned __int128 value = (unsigned __int128)a[i] + b[i] + carry;
+            sum[i] = uint64_t(value);
+            carry = uint64_t(value >> 64);
+        }
+        if (carry != 0 || !IsLess(sum, n_))
+        {
+            SubtractInPlace(sum, n_);
+        }
+        return sum;
+    }
+
+    Number Subtract(const Number & a, const Number & b) const
+    {
+        Number difference = a;
+        if (SubtractInPlace(difference, b))
+        {
+            AddInPlace(difference, n_);
+        }
+        return difference;
+    }
+
+    // a * b / R mod n by word-serial interleaved reduction (CIOS)
+    Number Multiply(const Number & a, const Number & b) const
+    {
+        std::array<uint64_t, N + 2> t = {};
+        for (size_t i = 0; i < N; ++i)
+        {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < N; ++j)
+            {
+                unsigned __int128 value = (unsigned __int128)a[j] * b[i] + t[j] + carry;
+                t[j] = uint64_t(value);
+                carry = uint64_t(value >> 64);
+            }
+            unsigned __int128 top = (unsigned __int128)t[N] + carry;
+            t[N] = uint64_t(top);
+            t[N + 1] = uint64_t(top >> 64);
+
+            // the multiple of n that clears the lowest word, the words are shifted down by one
+            uint64_t m = t[0] * inverse_;
+            unsigned __int128 value = (unsigned __int128)m * n_[0] + t[0];
+            carry = uint64_t(value >> 64);
+            for (size_t j = 1; j < N; ++j)
+            {
+                value = (unsigned __int128)m * n_[j] + t[j] + carry;
+                t[j - 1] = uint64_t(value);
+                carry = uint64_t(value >> 64);
+            }
+            top = (unsigned __int128)t[N] + carry;
+            t[N - 1] = uint64_t(top);
+            t[N] = t[N + 1] + uint64_t(top >> 64);
+        }
+
+        Number result;
+        std::copy(t.begin(), t.begin() + N, result.begin());
+        if (t[N] != 0 || !IsLess(result, n_))
+        {
+            SubtractInPlace(result, n_);
+        }
+        return result;
+    }
+
+    static bool IsZero(const Number & a)
+    {
+        return std::all_of(a.begin(), a.end(), [](uint64_t word) { return word == 0; });
+    }
+
+    // gcd(n, a) of any form of a, R is coprime to n; binary gcd, the factors 2 of a are dropped as n is odd
+    long_int Gcd(Number a) const
+    {
+        if (IsZero(a))
+        {
+            return ToLongInt(n_);
+        }
+        if constexpr (N == 1)
+        {
+            return long_int(std::gcd(n_[0], a[0]));
+        }
+        else
+        {
+            Number b = n_;
+            ShiftOutZeros(a);
+            while (true)
+            {
+                // both are odd
+                if (IsLess(a, b))
+                {
+                    std::swap(a, b);
+                }
+                SubtractInPlace(a, b);
+                if (IsZero(a))
+                {
+                    return ToLongInt(b);
+                }
+                ShiftOutZeros(a);
+            }
+        }
+    }
+
+   private:
+    static Number ToNumber(const long_int & x)
+    {
+        Number number = {};
+        export_bits(x, number.begin(), 64, false);
+        return number;
+    }
+
+    static long_int ToLongInt(const Number & number)
+    {
+        long_int x;
+        import_bits(x, number.begin(), number.end(), 64, false);
+        return x;
+    }
+
+    // -n^-1 mod 2^64 by Newton's iteration, every step doubles the correct low bits
+    static uint64_t ComputeInverse(uint64_t n)
+    {
+        uint64_t inverse = n;
+        for (size_t i = 0; i < 5; ++i)
+        {
+            inverse *= 2 - n * inverse;
+        }
+        return -inverse;
+    }
+
+    static bool IsLess(const Number & a, const Number & b)
+    {
+        for (size_t i = N; i-- > 0;)
+        {
+            if (a[i] != b[i])
+            {
+                return a[i] < b[i];
+            }
+        }
+        return false;
+    }
+
+    // the borrow out of the top word
+    static bool SubtractInPlace(Number & a, const Number & b)
+    {
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            unsigned __int128 value = (unsigned __int128)a[i] - b[i] - borrow;
+            a[i] = uint64_t(value);
+            borrow = uint64_t(value >> 64) & 1;
+        }
+        return borrow != 0;
+    }
+
+    static void AddInPlace(Number & a, const Number & b)
+    {
+        uint64_t carry = 0;
+        for (size_t i = 0; i < N; ++i)
+        {
+            unsigned __int128 value = (unsigned __int128)a[i] + b[i] + carry;
+            a[i] = uint64_t(value);
+            carry = uint64_t(value >> 64);
+        }
+    }
+
+    static void ShiftOutZeros(Number & a)
+    {
+        size_t words = 0;
+        for (; a[words] == 0; ++words)
+        {
+        }
+        size_t bits = std::countr_zero(a[words]);
+        for (size_t i = 0; i < N; ++i)
+        {
+            uint64_t low = i + words < N ? a[i + words] : 0;
+            uint64_t high = i + words + 1 < N ? a[i + words + 1] : 0;
+            a[i] = bits == 0 ? low : (low >> bits) | (high << (64 - bits));
+        }
+    }
+
+    Number n_;
+    uint64_t inverse_;
+    Number one_;
+};
+
+};  // namespace lpn
@@ -0,0 +1,106 @@
+#include "partial.hpp"
+
+namespace lpn
+{
+
+PartialRelations::PartialRelations(const long_int & n) : n_(n), cycles_(0) {}
+
+bool PartialRelations::Add(const long_int & value, FactorSet factor, size_t first, size_t second,
+                           Solution & solution)
+{
+    if (!seen_.insert(ComputeKey(value, n_)).second)
+    {
+        return false;
+    }
+
+    size_t from = GetVertex(first);
+    size_t to = GetVertex(second);
+    size_t from_root = FindRoot(from);
+    size_t to_root = FindRoot(to);
+
+    if (from_root != to_root)
+    {
+        parents_[from_root] = to_root;
+        edges_[from].push_back({to, values_.size()});
+        edges_[to].push_back({from, values_.size()});
+        values_.push_back(value);
+        factors_.push_back(std::move(factor));
+        return false;
+    }
+
+    // every large prime of the cycle appears in exactly two relations, so it has an even power in the product
+    long_int combined = value % n_;
+    for (auto relation : FindPath(from, to))
+    {
+        combined = (combined * values_[relation]) % n_;
+        MergeFactorSets(factor, factors_[relation]);
+    }
+    solution.values.push_back(std::move(combined));
+    solution.factors.Add(factor);
+    cycles_++;
+    return true;
+}
+
+long_int PartialRelations::ComputeKey(const long_int & value, const long_int & n)
+{
+    long_int key = value % n;
+    if (key < 0)
+    {
+        key += n;
+    }
+    return std::min(key, long_int(n - key));
+}
+
+size_t PartialRelations::Size() const { return values_.size(); }
+
+size_t PartialRelations::Cycles() const { return cycles_; }
+
+size_t PartialRelations::GetVertex(size_t prime)
+{
+    auto [iter, inserted] = vertices_.try_emplace(prime, parents_.size());
+    if (inserted)
+    {
+        parents_.push_back(parents_.size());
+        edges_.emplace_back();
+    }
+    return iter->second;
+}
+
+size_t PartialRelations::FindRoot(size_t vertex)
+{
+    while (parents_[vertex] != vertex)
+    {
+        parents_[vertex] = parents_[parents_[vertex]];
+        vertex = parents_[vertex];
+    }
+    return vertex;
+}
+
+std::vector<size_t> PartialRelations::FindPath(size_t from, size_t to) const
+{
+    // the stored edges form a spanning forest, so the path between two vertices of a component is unique
+    std::unordered_map<size_t, Edge> previous;
+    std::vector<size_t> stack = {from};
+    previous[from] = {from, 0};
+    while (!stack.empty() && !previous.contains(to))
+    {
+        size_t vertex = stack.back();
+        stack.pop_back();
+        for (const auto & edge : edges_[vertex])
+        {
+            if (previous.try_emplace(edge.vertex, Edge{vertex, edge.relation}).second)
+            {
+                stack.push_back(edge.vertex);
+            }
+        }
+    }
+
+    std::vector<size_t> path;
+    for (size_t vertex = to; vertex != from; vertex = previous[vertex].vertex)
+    {
+        path.push_back(previous[vertex].relation);
+    }
+    return path;
+}
+
+};  // namespace lpn
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "base.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace lpn
+{
+
+// Relations with one or two primes outside of the factor base. Large primes are vertices of a graph, every partial
+// relation is an edge between its primes (a single large prime is joined to the vertex 1). Components are tracked
+// with union-find, so an edge inside a component closes a cycle whose relations multiply into a full relation. A value
+// seen before (or its negative modulo n) is dropped: the cycle it closes with its copy is a square on its own.
+class PartialRelations
+{
+   public:
+    explicit PartialRelations(const long_int & n);
+
+    bool Add(const long_int & value, FactorSet factor, size_t first, size_t second, Solution & solution);
+
+    // a value and its negative modulo n square to the same number, a relation is known by the smaller of the two
+    static long_int ComputeKey(const long_int & value, const long_int & n);
+
+    size_t Size() const;
+    size_t Cycles() const;
+
+   private:
+    struct Edge
+    {
+        size_t vertex;
+        size_t relation;
+    };
+
+    size_t GetVertex(size_t prime);
+    size_t FindRoot(size_t vertex);
+    std::vector<size_t> FindPath(size_t from, size_t to) const;
+
+   private:
+    const long_int n_;
+    size_t cycles_;
+    std::unordered_map<size_t, size_t> vertices_;
+    std::vector<size_t> parents_;
+    std::vector<std::vector<Edge>> edges_;
+    std::vector<long_int> values_;
+    FactorSets factors_;
+    std::unordered_set<long_int> seen_;
+};
+
+};  // namespace lpn
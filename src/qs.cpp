@@ -2,197 +2,1349 @@
 #include "base.hpp"
 #include "congruence.hpp"
 #include "gaussian.hpp"
+#include "rho.hpp"
 #include "thread_group.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace lpn
 {
 namespace math = boost::multiprecision;
 using Config = Sieve::Config;
 
-Config::Config(size_t segment_size, size_t factor_size, bool multi_thread)
-    : segment_size_(segment_size), factor_size_(factor_size), multi_thread_(multi_thread)
+SieveBlock::SieveBlock(size_t size) : left_(0), right_(0), data_((size + kScanWidth - 1) / kScanWidth * kScanWidth, 0)
+{
+}
+
+void SieveBlock::Reset(size_t left, size_t right)
+{
+    left_ = left;
+    right_ = right;
+    size_t length = (right - left + kScanWidth - 1) / kScanWidth * kScanWidth;
+    std::fill(data_.begin(), data_.begin() + length, 0);
+}
+
+void SieveBlock::AddPrime(uint32_t & i, uint32_t & j, uint32_t p, uint8_t p_log)
+{
+    if (i == j)
+    {
+        for (; i < right_; i += p)
+        {
+            data_[i - left_] += p_log;
+        }
+        j = i;
+        return;
+    }
+
+    if (j < i)
+    {
+        std::swap(i, j);
+    }
+
+    for (; j < right_; i += p, j += p)
+    {
+        data_[i - left_] += p_log;
+        data_[j - left_] += p_log;
+    }
+
+    if (i < right_)
+    {
+        data_[i - left_] += p_log;
+        i += p;
+    }
+}
+
+void SieveBlock::AddUpdates(const std::vector<SieveUpdate> & updates)
+{
+    for (const auto & update : updates)
+    {
+        data_[update.offset] += update.log;
+    }
+}
+
+void SieveBlock::FindCandidates(uint8_t threshold, std::vector<size_t> & candidates) const
+{
+    // the tail of the last block is zero filled and the threshold is never zero
+    assert(threshold > 0);
+    for (size_t k = 0; k < right_ - left_; k += kScanWidth)
+    {
+        for (uint64_t mask = ComputeMask(data_.data() + k, threshold); mask != 0; mask &= mask - 1)
+        {
+            candidates.push_back(left_ + k + std::countr_zero(mask));
+        }
+    }
+}
+
+uint64_t SieveBlock::ComputeMask(const uint8_t * data, uint8_t threshold)
+{
+    uint64_t mask = 0;
+#if defined(__AVX2__)
+    // data >= threshold <=> max(data, threshold) == data
+    __m256i limit = _mm256_set1_epi8(char(threshold));
+    for (size_t k = 0; k < kScanWidth; k += 32)
+    {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + k));
+        __m256i hit = _mm256_cmpeq_epi8(_mm256_max_epu8(value, limit), value);
+        mask |= uint64_t(uint32_t(_mm256_movemask_epi8(hit))) << k;
+    }
+#elif defined(__SSE2__)
+    __m128i limit = _mm_set1_epi8(char(threshold));
+    for (size_t k = 0; k < kScanWidth; k += 16)
+    {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + k));
+        __m128i hit = _mm_cmpeq_epi8(_mm_max_epu8(value, limit), value);
+        mask |= uint64_t(uint32_t(_mm_movemask_epi8(hit))) << k;
+    }
+#else
+    for (size_t k = 0; k < kScanWidth; ++k)
+    {
+        mask |= uint64_t(threshold <= data[k]) << k;
+    }
+#endif
+    return mask;
+}
+
+BucketSieve::BucketSieve(size_t block_size, size_t blocks)
+    : block_shift_(std::countr_zero(block_size)), left_(0), right_(0), buckets_(blocks)
+{
+    // block positions are computed with shifts and stored in 16 bits
+    assert(std::has_single_bit(block_size) && block_size <= (size_t(1) << 16));
+}
+
+void BucketSieve::Reset(size_t left, size_t right)
+{
+    left_ = left;
+    right_ = right;
+    for (auto & bucket : buckets_)
+    {
+        bucket.clear();
+    }
+}
+
+void BucketSieve::AddPrime(size_t entry, uint32_t & i, uint32_t & j, uint32_t p, uint8_t p_log)
+{
+    if (i == j)
+    {
+        for (; i < right_; i += p)
+        {
+            AddUpdate(entry, i, p_log);
+        }
+        j = i;
+        return;
+    }
+
+    for (; i < right_; i += p)
+    {
+        AddUpdate(entry, i, p_log);
+    }
+    for (; j < right_; j += p)
+    {
+        AddUpdate(entry, j, p_log);
+    }
+}
+
+const std::vector<SieveUpdate> & BucketSieve::GetBucket(size_t block_left) const
+{
+    return buckets_[(block_left - left_) >> block_shift_];
+}
+
+size_t BucketSieve::GetWindowSize() const { return buckets_.size() << block_shift_; }
+
+void BucketSieve::AddUpdate(size_t entry, size_t i, uint8_t p_log)
+{
+    size_t shift = i - left_;
+    size_t mask = (size_t(1) << block_shift_) - 1;
+    buckets_[shift >> block_shift_].push_back({uint32_t(entry), uint16_t(shift & mask), p_log});
+}
+
+Resieve::Resieve(size_t block_size) : left_(0), marks_(block_size, 0) {}
+
+void Resieve::Reset(size_t left, const std::vector<size_t> & candidates)
+{
+    for (auto i : candidates_)
+    {
+        marks_[i - left_] = 0;
+    }
+    left_ = left;
+    candidates_ = candidates;
+    entries_.resize(std::max(entries_.size(), candidates.size()));
+    for (size_t k = 0; k < candidates.size(); ++k)
+    {
+        marks_[candidates[k] - left] = uint16_t(k + 1);
+        entries_[k].clear();
+    }
+}
+
+void Resieve::AddPrime(size_t entry, uint32_t i, uint32_t j, uint32_t p)
+{
+    // the offsets have already passed the block, so they differ from a hit position by a multiple of p
+    for (size_t k = 0; k < candidates_.size(); ++k)
+    {
+        size_t x = candidates_[k];
+        if ((i - x) % p == 0 || (j - x) % p == 0)
+        {
+            entries_[k].push_back(uint32_t(entry));
+        }
+    }
+}
+
+void Resieve::AddUpdates(const std::vector<SieveUpdate> & updates)
+{
+    for (const auto & update : updates)
+    {
+        if (uint16_t mark = marks_[update.offset]; mark != 0)
+        {
+            entries_[mark - 1].push_back(update.entry);
+        }
+    }
+}
+
+const std::vector<uint32_t> & Resieve::GetEntries(size_t candidate) const { return entries_[candidate]; }
+
+double SieveFunction::ComputeMaxAbs(double left, double right) const
+{
+    auto compute = [this](double x) { return std::abs((a * x + b) * x + c); };
+    double value = std::max(compute(left), compute(right));
+    double vertex = -b / (2 * a);
+    if (left < vertex && vertex < right)
+    {
+        value = std::max(value, compute(vertex));
+    }
+    return value;
+}
+
+Config::Config(const long_int & n, size_t segment_size, size_t factor_size, bool multi_thread,
+               bool self_initializing)
+    : n_(n),
+      multiplier_(1),
+      segment_size_(segment_size),
+      block_size_(BasicConfig::kDefBlockSize),
+      factor_size_(factor_size),
+      multi_thread_(multi_thread),
+      self_initializing_(self_initializing),
+      large_prime_bound_(0),
+      double_large_primes_(false),
+      small_prime_bound_(0),
+      prime_power_bound_(0),
+      bucket_begin_(0),
+      linear_solver_(LinearSolver::kGaussian)
+{
+}
+
+Config & Config::SetLargePrimes(size_t multiplier, bool double_large_primes)
+{
+    // a cofactor is taken for a single large prime only below the square of the largest factor base prime
+    large_prime_bound_ = std::min(multiplier, primes_.back()) * primes_.back();
+    double_large_primes_ = double_large_primes;
+    ComputeCloseness(expansion_rate_);
+    return *this;
+}
+
+Config & Config::SetSmallPrimeVariation(size_t small_prime_bound, size_t prime_power_bound)
+{
+    small_prime_bound_ = small_prime_bound;
+    prime_power_bound_ = std::min(prime_power_bound, BasicConfig::kMaxPrimePowerBound);
+    ComputeSieveEntries();
+    ComputeCloseness(expansion_rate_);
+    return *this;
+}
+
+Config & Config::SetCheckpoint(const std::string & path)
+{
+    checkpoint_ = path;
+    return *this;
+}
+
+Config & Config::SetLinearSolver(LinearSolver solver)
 {
+    linear_solver_ = solver;
+    return *this;
 }
 
 Config Sieve::CreateConfig(const long_int & n, size_t segment_size, size_t factor_size, float expansion_rate,
                            bool multi_thread)
 {
-    Config config(segment_size, factor_size, multi_thread);
-    config.Reserve();
-    config.ComputePrimes(n);
-    config.ComputeTarget(n);
+    Config config(n, segment_size, factor_size, multi_thread);
+    config.ComputeMultiplier(n);
+    config.ComputePrimes(config.n_);
+    config.ComputeTarget(config.n_);
+    config.ComputeSieveEntries();
     config.ComputeCloseness(expansion_rate);
     return config;
 }
 
-Config Sieve::CreateConfig(const long_int & n)
+Config Sieve::CreateConfig(const long_int & n) { return CreateSelfInitializingConfig(n); }
+
+Config Sieve::CreateSelfInitializingConfig(const long_int & n, size_t segment_size, size_t factor_size,
+                                           float expansion_rate, bool multi_thread)
 {
-    return CreateConfig(n, BasicConfig::kDefSegmentSize, BasicConfig::kDefFactorSize, BasicConfig::kExpansionRate);
+    Config config(n, segment_size, factor_size, multi_thread, true);
+    config.ComputeMultiplier(n);
+    config.ComputePrimes(config.n_);
+    config.ComputeTarget(config.n_);
+    config.ComputeSieveEntries();
+    config.ComputeCloseness(expansion_rate);
+    return config;
+}
+
+Config Sieve::CreateSelfInitializingConfig(const long_int & n)
+{
+    Parameters parameters = ComputeParameters(n);
+    Config config = CreateSelfInitializingConfig(n, parameters.segment_size, parameters.factor_size,
+                                                 parameters.expansion_rate);
+    config.SetSmallPrimeVariation(BasicConfig::kDefSmallPrimeBound, BasicConfig::kDefPrimePowerBound);
+    if (parameters.large_prime_multiplier > 0)
+    {
+        config.SetLargePrimes(parameters.large_prime_multiplier, parameters.double_large_primes);
+    }
+    config.SetLinearSolver(parameters.factor_size < BasicConfig::kIncrementalFactorSize ? LinearSolver::kIncremental
+                                                                                        : LinearSolver::kGaussian);
+    return config;
+}
+
+Sieve::Parameters Sieve::ComputeParameters(const long_int & n)
+{
+    size_t digits = n.str().size();
+    // a smaller n keeps the first row, a single block is the least interval and with fewer primes some runs end short
+    if (digits <= kParameters.front().digits)
+    {
+        return kParameters.front();
+    }
+    if (digits >= kParameters.back().digits)
+    {
+        return kParameters.back();
+    }
+
+    auto upper = std::find_if(kParameters.begin(), kParameters.end(), [digits](const auto & row)
+                              { return row.digits >= digits; });
+    auto lower = std::prev(upper);
+    double t = double(digits - lower->digits) / double(upper->digits - lower->digits);
+    auto interpolate = [t](auto low, auto high) { return low + t * (double(high) - double(low)); };
+
+    Parameters parameters = *lower;
+    parameters.digits = digits;
+    parameters.factor_size = size_t(interpolate(lower->factor_size, upper->factor_size));
+    parameters.segment_size = size_t(interpolate(lower->segment_size, upper->segment_size));
+    parameters.expansion_rate = float(interpolate(lower->expansion_rate, upper->expansion_rate));
+    parameters.large_prime_multiplier =
+        size_t(interpolate(lower->large_prime_multiplier, upper->large_prime_multiplier));
+    return parameters;
 }
 
 void Config::ComputeCloseness(float expansion_rate)
 {
-    closeness_ = target_ - expansion_rate * log10(float(primes_.back()));
+    // unsieved small primes and a large prime cofactor are missing from the sieve, so the candidates may be farther
+    // from log|f(x)|
+    float closeness = expansion_rate * log2(float(primes_.back())) + small_primes_log_;
+    if (large_prime_bound_ > 0)
+    {
+        closeness += (double_large_primes_ ? 2 : 1) * log2(float(large_prime_bound_) / float(primes_.back()));
+    }
+    expansion_rate_ = expansion_rate;
+    closeness_ = uint8_t(std::min(std::round(closeness * log_scale_), BasicConfig::kMaxLogValue));
 }
 
-void Config::Reserve()
+uint8_t Config::ComputeThreshold(const SieveFunction & function, double left, double right) const
 {
-    primes_.reserve(factor_size_);
-    congruences_.reserve(factor_size_);
+    float value = log2(std::max(1.0, function.ComputeMaxAbs(left, right))) * log_scale_;
+    return uint8_t(std::clamp<float>(std::round(value) - closeness_, 1, BasicConfig::kMaxLogValue));
 }
 
-void Config::ComputeTarget(const long_int & n) { target_ = log10(double(n)) / 2 + log10(double(segment_size_)); }
+void Config::ComputeSieveEntries()
+{
+    moduli_.clear();
+    roots_.clear();
+    logs_.clear();
+    positions_.clear();
+    small_primes_log_ = 0;
 
-void Config::ComputePrimes(const long_int & n)
+    for (size_t pos = 0; pos < primes_.size(); ++pos)
+    {
+        size_t p = primes_[pos];
+        if (p < small_prime_bound_)
+        {
+            // p divides f(x) with the expected power 2 / (p - 1), or about 1 for p = 2
+            small_primes_log_ += log2(float(p)) * (p == 2 ? 1 : 2 / float(p - 1));
+            continue;
+        }
+        // every power of p adds one more log p at the positions it divides
+        auto log = uint8_t(std::max<float>(1, std::round(log2(float(p)) * log_scale_)));
+        size_t root = size_t(congruences_[pos]);
+        AddSieveEntry(p, root, log, pos);
+        // a prime of the multiplier divides k * n once (the root 0), so its square never divides f(x)
+        for (size_t q = p * p; p != 2 && root != 0 && q <= prime_power_bound_; q *= p)
+        {
+            root = LiftRoot(n_, root, q);
+            AddSieveEntry(q, root, log, pos);
+        }
+    }
+    SortSieveEntries();
+}
+
+void Config::AddSieveEntry(size_t modulus, size_t root, uint8_t log, size_t position)
+{
+    moduli_.push_back(uint32_t(modulus));
+    roots_.push_back(uint32_t(root));
+    logs_.push_back(log);
+    positions_.push_back(uint32_t(position));
+}
+
+void Config::SortSieveEntries()
+{
+    std::vector<size_t> order(moduli_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) { return moduli_[lhs] < moduli_[rhs]; });
+
+    auto permute = [&order](auto & values)
+    {
+        std::remove_reference_t<decltype(values)> sorted;
+        sorted.reserve(order.size());
+        for (auto pos : order)
+        {
+            sorted.push_back(values[pos]);
+        }
+        values = std::move(sorted);
+    };
+    permute(moduli_);
+    permute(roots_);
+    permute(logs_);
+    permute(positions_);
+    bucket_begin_ = std::lower_bound(moduli_.begin(), moduli_.end(), block_size_) - moduli_.begin();
+}
+
+void Config::ComputeDivisors(const std::vector<uint32_t> & entries, std::vector<size_t> & divisors) const
+{
+    // small primes are not sieved and are always tried
+    divisors.clear();
+    for (size_t pos = 0; pos < primes_.size() && primes_[pos] < small_prime_bound_; ++pos)
+    {
+        divisors.push_back(primes_[pos]);
+    }
+    for (auto entry : entries)
+    {
+        divisors.push_back(primes_[positions_[entry]]);
+    }
+    // prime powers hit together with their primes
+    std::sort(divisors.begin(), divisors.end());
+    divisors.erase(std::unique(divisors.begin(), divisors.end()), divisors.end());
+}
+
+size_t Config::LiftRoot(const long_int & n, size_t root, size_t modulus)
 {
-    primes_.push_back(2);
-    congruences_.push_back(n % 2);
+    // Hensel lifting from the previous power of the prime: t^2 = n mod q / p => (t - (t^2 - n) / 2t)^2 = n mod q
+    size_t n_mod = size_t(n % modulus);
+    size_t difference = ((root * root) % modulus + modulus - n_mod) % modulus;
+    size_t inverse = InverseWithMod((2 * root) % modulus, modulus);
+    return (root + modulus - (difference * inverse) % modulus) % modulus;
+}
 
-    for (size_t p = 3; primes_.size() <= factor_size_; p += 2)
+void Config::ComputeMultiplier(const long_int & n)
+{
+    // Knuth-Schroeppel: the expected log contribution of the small primes to f(x) for k * n, less the growth of
+    // f(x) by sqrt(k)
+    std::vector<size_t> primes = SievePrimes(3, BasicConfig::kMultiplierPrimeBound);
+    size_t n_mod8 = size_t(n % 8);
+    double best_score = -std::numeric_limits<double>::infinity();
+    for (size_t k : BasicConfig::kMultipliers)
     {
-        if (IsPrimeBasic(p) && ComputeLegendreSymbol(n, p) == 1)
+        if (n % k == 0 && k != 1)
+        {
+            continue;
+        }
+        double score = -0.5 * log(double(k));
+        switch ((k * n_mod8) % 8)
+        {
+            case 1:
+                score += 2 * log(2.0);
+                break;
+            case 5:
+                score += log(2.0);
+                break;
+            case 3:
+            case 7:
+                score += 0.5 * log(2.0);
+                break;
+            default:
+                break;
+        }
+        for (size_t p : primes)
         {
-            primes_.push_back(p);
-            congruences_.push_back(QuadraticCongruences::Solve(n, p));
+            if (k % p == 0)
+            {
+                score += log(double(p)) / double(p);
+            }
+            else if (ComputeLegendreSymbol(k * size_t(n % p), p) == 1)
+            {
+                score += 2 * log(double(p)) / double(p - 1);
+            }
+        }
+        if (score > best_score)
+        {
+            best_score = score;
+            multiplier_ = k;
         }
     }
+    n_ = multiplier_ * n;
+}
+
+void Config::ComputeTarget(const long_int & n)
+{
+    // |f(x)| <= 2 * sqrt(n) * segment_size, the logarithms are scaled so that their sums fit into a byte
+    target_ = log2(double(n)) / 2 + log2(double(segment_size_)) + 1;
+    log_scale_ = std::min<float>(1, BasicConfig::kMaxLogValue / target_);
+}
+
+void Config::ComputePrimes(const long_int & n)
+{
+    // the primes of the multiplier divide n, they are in the base with the single root 0
+    FactorBase base = ComputeFactorBase(n, factor_size_ + 1);
+    primes_ = std::move(base.primes);
+    congruences_ = std::move(base.roots);
 }
 
 FactorSet QuadraticSieveFactorization::Factorize(const long_int & n, const Sieve::Config & config)
 {
     Solution solution = Sieve::Solve(n, config);
-    GaussianBasic gs = GaussianBasic(solution.factors, solution.primes);
-    Matrix matrix = gs.Solve();
-    return FindFactor(solution, matrix, n);
+    if (!solution.factor.empty())
+    {
+        return solution.factor;
+    }
+    if (!solution.complete)
+    {
+        return FactorSet{{n, 1}};
+    }
+    auto null_space = SolveLinearSystem(solution, config.linear_solver_, config.multi_thread_);
+    return FindFactor(solution, null_space, n, config.multi_thread_);
 }
 
 FactorSet QuadraticSieveFactorization::Factorize(const long_int & n) { return Factorize(n, Sieve::CreateConfig(n)); }
 
 Sieve::Sieve(const long_int & n, const Config & config)
-    : r_(math::sqrt(n) - config.segment_size_), sieve_(2 * config.segment_size_, 0.0)
+    : r_(math::sqrt(n) - config.segment_size_),
+      size_(2 * config.segment_size_),
+      function_({1, 2 * double(r_), double(r_ * r_ - n)}),
+      residues_(config.moduli_.size())
 {
+    // the offsets pass the end of the interval by less than a modulus
+    assert(config.moduli_.empty() || size_ + config.moduli_.back() <= UINT32_MAX);
+    for (size_t pos = 0; pos < config.moduli_.size(); ++pos)
+    {
+        residues_[pos] = uint32_t(r_ % config.moduli_[pos]);
+    }
 }
 
-Solution Sieve::Solve(const long_int & n, const Config & config)
+Solution Sieve::Solve([[maybe_unused]] const long_int & n, const Config & config)
 {
-    Sieve sieve(n, config);
+    assert(config.n_ == config.multiplier_ * n);
+    const long_int & kn = config.n_;
+    if (config.self_initializing_)
+    {
+        return SelfInitializingSieve::Solve(kn, config);
+    }
+
+    Sieve sieve(kn, config);
     if (config.multi_thread_)
     {
-        sieve.ComputeSieveMultiThread(config, n);
+        return sieve.ComputeSieveMultiThread(config, kn);
     }
-    else
+
+    RelationCollector collector(kn, config);
+    sieve.ComputeSieve(config, kn, 0, sieve.size_, collector);
+    return collector.TakeSolution();
+}
+
+void Sieve::ComputeSieve(const Config & config, const long_int & n, size_t left_border, size_t right_border,
+                         RelationCollector & collector, size_t worker)
+{
+    SieveBlock block(config.block_size_);
+    BucketSieve buckets(config.block_size_);
+    Resieve resieve(config.block_size_);
+    std::vector<uint32_t> offsets = ComputeOffsets(config, left_border);
+    std::vector<size_t> candidates;
+    for (size_t left = left_border; left < right_border && !collector.IsComplete(); left += config.block_size_)
     {
-        sieve.ComputeSieve(config, 0, sieve.sieve_.size());
+        if ((left - left_border) % buckets.GetWindowSize() == 0)
+        {
+            buckets.Reset(left, std::min(left + buckets.GetWindowSize(), right_border));
+            for (size_t pos = config.bucket_begin_; pos < config.moduli_.size(); ++pos)
+            {
+                buckets.AddPrime(pos, offsets[2 * pos], offsets[2 * pos + 1], config.moduli_[pos],
+                                 config.logs_[pos]);
+            }
+        }
+        size_t right = std::min(left + config.block_size_, right_border);
+        block.Reset(left, right);
+        for (size_t pos = 0; pos < config.bucket_begin_; ++pos)
+        {
+            block.AddPrime(offsets[2 * pos], offsets[2 * pos + 1], config.moduli_[pos], config.logs_[pos]);
+        }
+        block.AddUpdates(buckets.GetBucket(left));
+
+        candidates.clear();
+        block.FindCandidates(config.ComputeThreshold(function_, double(left), double(right - 1)), candidates);
+        if (candidates.empty())
+        {
+            continue;
+        }
+        resieve.Reset(left, candidates);
+        for (size_t pos = 0; pos < config.bucket_begin_; ++pos)
+        {
+            resieve.AddPrime(pos, offsets[2 * pos], offsets[2 * pos + 1], config.moduli_[pos]);
+        }
+        resieve.AddUpdates(buckets.GetBucket(left));
+        FindAllFactorizable(config, n, candidates, resieve, collector, worker);
+    }
+}
+
+Solution Sieve::ComputeSieveMultiThread(const Config & config, const long_int & n)
+{
+    // tasks are windows of the bucket sieve, the workers sieve and scan their own blocks while the verifiers
+    // decompose the candidates
+    size_t threads = ThreadGroup::GetThreadAmount();
+    size_t verifiers = RelationCollector::GetVerifierAmount(threads);
+    size_t workers = std::max<size_t>(1, threads - verifiers);
+    RelationCollector collector(n, config, workers);
+    collector.StartVerifiers(verifiers);
+
+    WorkStealingPool pool(workers);
+    size_t step = BucketSieve::kDefWindowBlocks * config.block_size_;
+    for (size_t left = 0; left < size_; left += step)
+    {
+        pool.AddTask(
+            [this, left, step, &config, &n, &collector](size_t worker)
+            {
+                if (!collector.IsComplete())
+                {
+                    ComputeSieve(config, n, left, std::min(left + step, size_), collector, worker);
+                }
+            });
     }
-    Solution solution = sieve.FindAllFactorizable(config, n);
-    solution.primes = config.primes_;
-    return solution;
+    pool.Wait();
+    return collector.TakeSolution();
 }
 
-void Sieve::ComputeSieve(const Config & config, size_t left_border, size_t right_border)
+std::vector<uint32_t> Sieve::ComputeOffsets(const Config & config, size_t left_border) const
 {
-    for (size_t pos = 0; pos < config.primes_.size(); pos++)
+    std::vector<uint32_t> offsets(2 * config.moduli_.size());
+    for (size_t pos = 0; pos < config.moduli_.size(); pos++)
     {
-        size_t p = config.primes_[pos];
+        size_t p = config.moduli_[pos];
+        size_t r = residues_[pos];
         // n = x^2 mod p; f(r) = r^2 - n; target f(r) == 0 mod p
-        size_t i = (size_t)((config.congruences_[pos] + p - (r_ % p)) % p);
-        size_t j = (size_t)((2 * p - config.congruences_[pos] - (r_ % p)) % p);
-        AddPrimeInSieve(i, j, p, left_border, right_border);
+        size_t i = (config.roots_[pos] + p - r) % p;
+        size_t j = (2 * p - config.roots_[pos] - r) % p;
+        if (i < left_border)
+        {
+            i += ((left_border - i + p - 1) / p) * p;
+        }
+        if (j < left_border)
+        {
+            j += ((left_border - j + p - 1) / p) * p;
+        }
+        offsets[2 * pos] = uint32_t(i);
+        offsets[2 * pos + 1] = uint32_t(j);
     }
+    return offsets;
 }
 
-void Sieve::ComputeSieveMultiThread(const Config & config, const long_int & n)
+void Sieve::FindAllFactorizable(const Config & config, const long_int & n, const std::vector<size_t> & candidates,
+                                const Resieve & resieve, RelationCollector & collector, size_t worker)
 {
-    int threads = ThreadGroup::GetThreadAmount();
-    auto group = ThreadGroup();
-    for (size_t pos = 0; pos < threads; ++pos)
+    std::vector<size_t> divisors;
+    for (size_t k = 0; k < candidates.size(); ++k)
     {
-        group.AddTask(
-            [pos, config, this, threads]() mutable
-            { this->ComputeSieve(config, ComputeLeftBorder(threads, pos), ComputeRightBorder(threads, pos)); });
+        if (collector.IsComplete())
+        {
+            return;
+        }
+        config.ComputeDivisors(resieve.GetEntries(k), divisors);
+        collector.Add(r_ + candidates[k], ComputeTargetFunction(n, candidates[k]), FactorSet(), divisors, worker);
     }
-    group.ComputeAllTasks();
 }
 
-Solution Sieve::FindAllFactorizable(const Config & config, const long_int & n)
+long_int Sieve::ComputeTargetFunction(const long_int & n, size_t i) const { return (r_ + i) * (r_ + i) - n; }
+
+SelfInitializingSieve::SelfInitializingSieve(const long_int & n, const Config & config, size_t worker)
+    : n_(n),
+      config_(config),
+      worker_(worker),
+      radius_(config.segment_size_),
+      a_target_(math::sqrt(long_int(2 * n)) / config.segment_size_),
+      block_(config.block_size_),
+      buckets_(config.block_size_),
+      resieve_(config.block_size_),
+      offsets_(2 * config.moduli_.size()),
+      first_roots_(config.moduli_.size()),
+      second_roots_(config.moduli_.size()),
+      is_a_factor_(config.moduli_.size(), false),
+      gen_(BasicConfig::kSeed)
+{
+    assert(config.moduli_.empty() || 2 * radius_ + config.moduli_.back() <= UINT32_MAX);
+}
+
+Solution SelfInitializingSieve::Solve(const long_int & n, const Config & config)
+{
+    if (config.multi_thread_)
+    {
+        return SolveMultiThread(n, config);
+    }
+
+    SelfInitializingSieve sieve(n, config);
+    RelationCollector collector(n, config);
+    // a resumed run starts from other values of A, the relations it finds again are skipped by the collector
+    sieve.gen_.seed(BasicConfig::kSeed + collector.GetRuns());
+    while (!collector.IsComplete() && sieve.ChooseA())
+    {
+        sieve.SievePolynomials(collector);
+    }
+    return collector.TakeSolution();
+}
+
+Solution SelfInitializingSieve::SolveMultiThread(const long_int & n, const Config & config)
 {
-    Solution solution;
-    for (size_t i = 0; i < sieve_.size(); ++i)
+    // every worker keeps its own sieve, the values of A are chosen here and handed out as tasks, the candidates are
+    // decomposed by the verifiers
+    size_t threads = ThreadGroup::GetThreadAmount();
+    size_t verifiers = RelationCollector::GetVerifierAmount(threads);
+    size_t workers = std::max<size_t>(1, threads - verifiers);
+    std::vector<std::unique_ptr<SelfInitializingSieve>> sieves;
+    for (size_t worker = 0; worker < workers; ++worker)
     {
-        if (config.closeness_ <= sieve_[i] && solution.values.size() < 1.1 * config.factor_size_)
+        sieves.emplace_back(new SelfInitializingSieve(n, config, worker));
+    }
+    SelfInitializingSieve planner(n, config);
+    RelationCollector collector(n, config, workers);
+    planner.gen_.seed(BasicConfig::kSeed + collector.GetRuns());
+    collector.StartVerifiers(verifiers);
+    {
+        WorkStealingPool pool(workers);
+        while (!collector.IsComplete() && planner.ChooseA())
         {
-            auto factor = TryToDecompose(config.primes_, ComputeTargetFunction(n, i));
-            AddFactor(factor, i, solution);
+            pool.AddTask(
+                [&sieves, &collector, a = planner.a_, a_factors = planner.a_factors_](size_t worker)
+                {
+                    if (collector.IsComplete())
+                    {
+                        return;
+                    }
+                    auto & sieve = *sieves[worker];
+                    sieve.a_ = a;
+                    sieve.a_factors_ = a_factors;
+                    sieve.SievePolynomials(collector);
+                });
+            // a short backlog keeps every worker busy without choosing A far ahead of the early stop
+            pool.Wait(2 * workers);
         }
     }
-    return solution;
+    return collector.TakeSolution();
 }
 
-void Sieve::AddFactor(const std::optional<FactorSet> & factor, size_t i, Solution & solution) const
+bool SelfInitializingSieve::ChooseA()
 {
-    if (factor)
+    const auto & primes = config_.primes_;
+    double log_target = std::max(0.0, log(double(a_target_)));
+
+    // factors of A are never sieved, so they are taken from the upper part of the factor base
+    size_t left = std::lower_bound(primes.begin(), primes.end(), BasicConfig::kMinFactorValue) - primes.begin();
+    left = std::clamp<size_t>(left, 1, primes.size() / 2);
+    size_t amount = std::max<size_t>(1, size_t(log_target / log(double(primes[left]))));
+    amount = std::min(amount, primes.size() - left - 1);
+
+    double factor_value = exp(log_target / double(amount));
+    size_t lower = std::lower_bound(primes.begin(), primes.end(), size_t(factor_value / 2)) - primes.begin();
+    size_t upper = std::lower_bound(primes.begin(), primes.end(), size_t(factor_value * 2)) - primes.begin();
+    lower = std::max(lower, left);
+    if (upper <= lower || upper - lower < 2 * amount)
     {
-        solution.values.push_back(i + r_);
-        solution.factors.push_back(std::move(factor.value()));
+        lower = left;
+        upper = primes.size();
     }
+
+    for (size_t attempt = 0; attempt < BasicConfig::kMaxAttempts; ++attempt)
+    {
+        ChooseFactorsOfA(amount, lower, upper);
+        if (!a_factors_.empty() && used_a_.insert(a_).second)
+        {
+            return true;
+        }
+    }
+    // the values of A close to the target are used up (a small n has few of them), the factors come from the whole
+    // upper part of the factor base and the last one moves away from the target
+    for (size_t attempt = 0; attempt < BasicConfig::kMaxAttempts; ++attempt)
+    {
+        ChooseFactorsOfA(amount, left, primes.size());
+        if (!a_factors_.empty() && (used_a_.insert(a_).second || ReplaceLastFactor(left)))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
-void Sieve::AddPrimeInSieve(size_t i, size_t j, size_t p, size_t left_border, size_t right_border)
+bool SelfInitializingSieve::ReplaceLastFactor(size_t left)
 {
-    if (i < left_border)
+    const auto & primes = config_.primes_;
+    size_t last = a_factors_.back();
+    a_factors_.pop_back();
+    long_int rest = a_ / primes[last];
+    // the primes nearest to the last factor first, on both sides of it
+    for (size_t distance = 1; distance < primes.size(); ++distance)
     {
-        i += ((left_border - i + p - 1) / p) * p;
+        // below zero the position wraps around past the end
+        for (size_t pos : {last - distance, last + distance})
+        {
+            if (pos < left || pos >= primes.size() ||
+                std::find(a_factors_.begin(), a_factors_.end(), pos) != a_factors_.end())
+            {
+                continue;
+            }
+            long_int a = rest * primes[pos];
+            if (used_a_.insert(a).second)
+            {
+                a_factors_.push_back(pos);
+                a_ = std::move(a);
+                return true;
+            }
+        }
     }
-    if (j < left_border)
+    a_factors_.clear();
+    return false;
+}
+
+void SelfInitializingSieve::ChooseFactorsOfA(size_t amount, size_t left, size_t right)
+{
+    const auto & primes = config_.primes_;
+    std::uniform_int_distribution<size_t> distrib(left, right - 1);
+
+    a_factors_.clear();
+    a_ = 1;
+    while (a_factors_.size() + 1 < amount)
     {
-        j += ((left_border - j + p - 1) / p) * p;
+        size_t pos = distrib(gen_);
+        if (std::find(a_factors_.begin(), a_factors_.end(), pos) == a_factors_.end())
+        {
+            a_factors_.push_back(pos);
+            a_ *= primes[pos];
+        }
     }
 
-    if (j < i)
+    // the last factor brings A as close to the target as the factor base allows
+    long_int rest = a_target_ / a_;
+    size_t last = std::lower_bound(primes.begin() + left, primes.end(), rest) - primes.begin();
+    last = std::min(last, primes.size() - 1);
+    while (last > left && std::find(a_factors_.begin(), a_factors_.end(), last) != a_factors_.end())
     {
-        std::swap(i, j);
+        --last;
     }
+    if (std::find(a_factors_.begin(), a_factors_.end(), last) != a_factors_.end())
+    {
+        a_factors_.clear();
+        return;
+    }
+    a_factors_.push_back(last);
+    a_ *= primes[last];
+}
 
-    float p_log = log10(float(p));
+void SelfInitializingSieve::InitializePolynomial()
+{
+    const auto & primes = config_.primes_;
+    size_t amount = a_factors_.size();
 
-    if (i == j)
+    std::vector<size_t> gammas(amount);
+    b_terms_.assign(amount, 0);
+    b_ = 0;
+    for (size_t j = 0; j < amount; ++j)
+    {
+        size_t pos = a_factors_[j];
+        size_t q = primes[pos];
+        long_int a_q = a_ / q;
+        size_t gamma = (size_t(config_.congruences_[pos]) * InverseWithMod(size_t(a_q % q), q)) % q;
+        if (gamma > q / 2)
+        {
+            gamma = q - gamma;
+        }
+        gammas[j] = gamma;
+        b_terms_[j] = a_q * gamma;
+        b_ += b_terms_[j];
+    }
+
+    // every residue below comes from the factors of A and the gammas, so a prime costs no big integer division:
+    // B_j = (A / q_j) * gamma_j, where A / q_j mod p is a product of prefix and suffix products of the factors
+    const auto & roots = config_.roots_;
+    std::vector<uint64_t> prefix(amount + 1);
+    std::vector<uint64_t> terms(amount);
+    b_inverse_.assign(amount, std::vector<uint32_t>(config_.moduli_.size(), 0));
+    for (size_t pos = 0; pos < config_.moduli_.size(); ++pos)
+    {
+        size_t position = config_.positions_[pos];
+        is_a_factor_[pos] = std::find(a_factors_.begin(), a_factors_.end(), position) != a_factors_.end();
+        if (is_a_factor_[pos])
+        {
+            continue;
+        }
+        uint64_t p = config_.moduli_[pos];
+        prefix[0] = 1;
+        for (size_t j = 0; j < amount; ++j)
+        {
+            prefix[j + 1] = prefix[j] * (primes[a_factors_[j]] % p) % p;
+        }
+        uint64_t suffix = 1;
+        uint64_t b_mod = 0;
+        for (size_t j = amount; j-- > 0;)
+        {
+            terms[j] = prefix[j] * suffix % p * (gammas[j] % p) % p;
+            b_mod = (b_mod + terms[j]) % p;
+            suffix = suffix * (primes[a_factors_[j]] % p) % p;
+        }
+        uint64_t a_inverse = InverseWithMod(size_t(prefix[amount]), size_t(p));
+        uint64_t shift = radius_ % p;
+        // (Ax + B)^2 = n mod p <=> x = A^(-1) (+-t - B) mod p, shifted by M into the sieve
+        first_roots_[pos] = uint32_t((a_inverse * ((roots[pos] + p - b_mod) % p) + shift) % p);
+        second_roots_[pos] = uint32_t((a_inverse * ((2 * p - roots[pos] - b_mod) % p) + shift) % p);
+        for (size_t j = 0; j < amount; ++j)
+        {
+            b_inverse_[j][pos] = uint32_t(2 * terms[j] % p * a_inverse % p);
+        }
+    }
+    ComputeFunction();
+}
+
+void SelfInitializingSieve::NextPolynomial(size_t index)
+{
+    const auto & moduli = config_.moduli_;
+    size_t term = std::countr_zero(index) + 1;
+    bool add = ((index >> term) & 1) == 1;
+
+    if (add)
+    {
+        b_ += 2 * b_terms_[term];
+    }
+    else
+    {
+        b_ -= 2 * b_terms_[term];
+    }
+    for (size_t pos = 0; pos < moduli.size(); ++pos)
+    {
+        if (is_a_factor_[pos])
+        {
+            continue;
+        }
+        size_t p = moduli[pos];
+        size_t delta = add ? p - b_inverse_[term][pos] : b_inverse_[term][pos];
+        first_roots_[pos] = (first_roots_[pos] + delta) % p;
+        second_roots_[pos] = (second_roots_[pos] + delta) % p;
+    }
+    ComputeFunction();
+}
+
+void SelfInitializingSieve::SievePolynomials(RelationCollector & collector)
+{
+    InitializePolynomial();
+    size_t polynomials = size_t(1) << (a_factors_.size() - 1);
+    for (size_t index = 0; index < polynomials && !collector.IsComplete(); ++index)
+    {
+        if (index > 0)
+        {
+            NextPolynomial(index);
+        }
+        ComputeSieve(collector);
+    }
+}
+
+void SelfInitializingSieve::ComputeFunction()
+{
+    // (Ax + B)^2 - n = A * (Ax^2 + 2Bx + C), the sieve collects the logarithm of the second factor
+    function_ = {double(a_), 2 * double(b_), double(long_int((b_ * b_ - n_) / a_))};
+}
+
+void SelfInitializingSieve::ComputeSieve(RelationCollector & collector)
+{
+    const auto & moduli = config_.moduli_;
+    for (size_t pos = 0; pos < moduli.size(); ++pos)
     {
-        while (i < right_border)
+        offsets_[2 * pos] = first_roots_[pos];
+        offsets_[2 * pos + 1] = second_roots_[pos];
+    }
+
+    for (size_t left = 0; left < 2 * radius_ && !collector.IsComplete(); left += config_.block_size_)
+    {
+        if (left % buckets_.GetWindowSize() == 0)
+        {
+            buckets_.Reset(left, std::min(left + buckets_.GetWindowSize(), 2 * radius_));
+            for (size_t pos = config_.bucket_begin_; pos < moduli.size(); ++pos)
+            {
+                if (!is_a_factor_[pos])
+                {
+                    buckets_.AddPrime(pos, offsets_[2 * pos], offsets_[2 * pos + 1], moduli[pos],
+                                      config_.logs_[pos]);
+                }
+            }
+        }
+        size_t right = std::min(left + config_.block_size_, 2 * radius_);
+        block_.Reset(left, right);
+        for (size_t pos = 0; pos < config_.bucket_begin_; ++pos)
         {
-            sieve_[i] += p_log;
-            i += p;
+            if (!is_a_factor_[pos])
+            {
+                block_.AddPrime(offsets_[2 * pos], offsets_[2 * pos + 1], moduli[pos], config_.logs_[pos]);
+            }
         }
+        block_.AddUpdates(buckets_.GetBucket(left));
+
+        double x_left = double(left) - double(radius_);
+        double x_right = double(right - 1) - double(radius_);
+        candidates_.clear();
+        block_.FindCandidates(config_.ComputeThreshold(function_, x_left, x_right), candidates_);
+        if (candidates_.empty())
+        {
+            continue;
+        }
+        resieve_.Reset(left, candidates_);
+        for (size_t pos = 0; pos < config_.bucket_begin_; ++pos)
+        {
+            if (!is_a_factor_[pos])
+            {
+                resieve_.AddPrime(pos, offsets_[2 * pos], offsets_[2 * pos + 1], moduli[pos]);
+            }
+        }
+        resieve_.AddUpdates(buckets_.GetBucket(left));
+        FindAllFactorizable(collector);
+    }
+}
+
+void SelfInitializingSieve::FindAllFactorizable(RelationCollector & collector)
+{
+    for (size_t k = 0; k < candidates_.size(); ++k)
+    {
+        if (collector.IsComplete())
+        {
+            return;
+        }
+        long_int value = ComputeValue(candidates_[k]);
+        // (Ax + B)^2 - n = A * (Ax^2 + 2Bx + C), the factors of A are known in advance and may divide the rest again
+        FactorSet factor;
+        config_.ComputeDivisors(resieve_.GetEntries(k), divisors_);
+        for (auto pos : a_factors_)
+        {
+            factor[config_.primes_[pos]] += 1;
+            divisors_.push_back(config_.primes_[pos]);
+        }
+        collector.Add(math::abs(value), (value * value - n_) / a_, std::move(factor), divisors_, worker_);
+    }
+}
+
+long_int SelfInitializingSieve::ComputeValue(size_t i) const
+{
+    return a_ * (long_int(i) - long_int(radius_)) + b_;
+}
+
+RelationCollector::RelationCollector(const long_int & n, const Config & config, size_t workers)
+    : n_(n),
+      config_(config),
+      target_(1.1 * config.factor_size_),
+      workers_(workers),
+      relations_(0),
+      prime_index_(Relations::CreateIndex(config.primes_)),
+      buffers_(workers, Buffer{{}, Relations(prime_index_)}),
+      solution_(config.primes_),
+      partials_(n),
+      queue_(kQueueSize),
+      stop_(false),
+      runs_(0)
+{
+    if (config.linear_solver_ == LinearSolver::kIncremental)
+    {
+        incremental_ = std::make_unique<IncrementalSolver>(config.n_ / config.multiplier_, config.primes_.size());
+    }
+    if (!config.checkpoint_.empty())
+    {
+        LoadCheckpoint();
+    }
+    std::unique_lock lock(mutex_);
+    UpdateIncremental(lock);
+}
+
+void RelationCollector::LoadCheckpoint()
+{
+    file_ = std::make_unique<RelationFile>(config_.checkpoint_, n_, config_.primes_);
+    for (const auto & relation : file_->GetRelations())
+    {
+        if (relation.second == 1)
+        {
+            if (!full_values_.insert(PartialRelations::ComputeKey(relation.value, n_)).second)
+            {
+                continue;
+            }
+            solution_.values.push_back(relation.value);
+            solution_.factors.Add(relation.factor);
+            relations_++;
+        }
+        else if (partials_.Add(relation.value, relation.factor, relation.first, relation.second, solution_))
+        {
+            relations_++;
+        }
+    }
+    // every run leaves a mark, so that the next one can choose other polynomials
+    runs_ = file_->GetProgress().size();
+    file_->AddProgress({});
+}
+
+RelationCollector::~RelationCollector() { StopVerifiers(); }
+
+void RelationCollector::Add(const long_int & value, long_int rest, FactorSet factor,
+                            const std::vector<size_t> & divisors, size_t worker)
+{
+    if (verifiers_.empty())
+    {
+        Verify(value, std::move(rest), std::move(factor), divisors, worker);
         return;
     }
 
-    while (j < right_border)
+    Candidate candidate = {value, std::move(rest), std::move(factor), divisors};
+    while (!queue_.TryPush(std::move(candidate)))
     {
-        sieve_[i] += p_log;
-        sieve_[j] += p_log;
-        i += p;
-        j += p;
+        // the verifiers are behind, so the sieve waits for them unless the run is already complete
+        if (IsComplete())
+        {
+            return;
+        }
+        std::this_thread::yield();
     }
+}
+
+size_t RelationCollector::GetVerifierAmount(size_t threads)
+{
+    return std::max<size_t>(1, threads / (kSieversPerVerifier + 1));
+}
 
-    if (i < right_border)
+void RelationCollector::StartVerifiers(size_t verifiers)
+{
+    stop_ = false;
+    buffers_.resize(workers_ + verifiers, Buffer{{}, Relations(prime_index_)});
+    for (size_t pos = 0; pos < verifiers; ++pos)
     {
-        sieve_[i] += p_log;
+        verifiers_.emplace_back([this, pos]() { RunVerifier(workers_ + pos); });
     }
 }
 
-long_int Sieve::ComputeTargetFunction(const long_int & n, size_t i) const { return math::abs((r_ + i) * (r_ + i) - n); }
+void RelationCollector::StopVerifiers()
+{
+    stop_ = true;
+    for (auto & verifier : verifiers_)
+    {
+        verifier.join();
+    }
+    verifiers_.clear();
+}
 
-size_t Sieve::ComputeLeftBorder(size_t threads, size_t position) const
+void RelationCollector::RunVerifier(size_t buffer)
 {
-    return ((sieve_.size()) / threads) * position;
+    Candidate candidate;
+    while (true)
+    {
+        // the queue is drained once more after the stop, no candidate pushed before it is lost
+        bool stop = stop_;
+        if (queue_.TryPop(candidate))
+        {
+            if (!IsComplete())
+            {
+                Verify(candidate.value, std::move(candidate.rest), std::move(candidate.factor), candidate.divisors,
+                       buffer);
+            }
+            continue;
+        }
+        if (stop)
+        {
+            return;
+        }
+        std::this_thread::yield();
+    }
 }
 
-size_t Sieve::ComputeRightBorder(size_t threads, size_t position) const
+void RelationCollector::Verify(const long_int & value, long_int rest, FactorSet factor,
+                               const std::vector<size_t> & divisors, size_t buffer)
 {
-    if (position + 1 == threads)
+    if (file_ && file_->Contains(value))
+    {
+        return;
+    }
+    if (rest < 0)
+    {
+        factor[-1] = 1;
+        rest = -rest;
+    }
+    ExtractFactors(divisors, rest, factor);
+
+    std::pair<size_t, size_t> large_primes = {1, 1};
+    if (rest != 1)
+    {
+        auto split = SplitCofactor(rest);
+        if (!split)
+        {
+            return;
+        }
+        large_primes = split.value();
+    }
+
+    if (rest == 1 && incremental_)
+    {
+        long_int key = PartialRelations::ComputeKey(value, n_);
+        std::unique_lock lock(mutex_);
+        if (relations_ < target_ && full_values_.insert(std::move(key)).second)
+        {
+            if (file_)
+            {
+                file_->AddRelation({value, factor});
+            }
+            solution_.values.push_back(value);
+            solution_.factors.Add(factor);
+            relations_++;
+            UpdateIncremental(lock);
+        }
+        return;
+    }
+    if (rest == 1)
+    {
+        // the same value is often found by several polynomials, a copy would count as a relation but add no row
+        long_int key = PartialRelations::ComputeKey(value, n_);
+        {
+            std::lock_guard lock(mutex_);
+            if (!full_values_.insert(std::move(key)).second)
+            {
+                return;
+            }
+        }
+        // the rest needs no shared state besides the counter
+        if (relations_.fetch_add(1) < target_)
+        {
+            if (file_)
+            {
+                file_->AddRelation({value, factor});
+            }
+            buffers_[buffer].values.push_back(value);
+            buffers_[buffer].factors.Add(factor);
+        }
+        return;
+    }
+
+    if (large_primes.first != 1)
+    {
+        factor[large_primes.first] += 1;
+    }
+    factor[large_primes.second] += 1;
+    std::unique_lock lock(mutex_);
+    if (relations_ >= target_)
+    {
+        return;
+    }
+    if (file_)
+    {
+        file_->AddRelation({value, factor, large_primes.first, large_primes.second});
+    }
+    if (partials_.Add(value, std::move(factor), large_primes.first, large_primes.second, solution_))
+    {
+        relations_++;
+        UpdateIncremental(lock);
+    }
+}
+
+void RelationCollector::UpdateIncremental(std::unique_lock<std::mutex> & lock)
+{
+    // the square root of a dependency is taken without the lock, the run is complete at the first factor
+    while (incremental_ && solution_.factor.empty())
+    {
+        auto dependency = incremental_->NextDependency(solution_);
+        if (!dependency.has_value())
+        {
+            return;
+        }
+        lock.unlock();
+        auto factor = incremental_->TryCopiedDependency(dependency.value());
+        lock.lock();
+        if (factor.has_value() && solution_.factor.empty())
+        {
+            solution_.factor = std::move(factor.value());
+            relations_ = target_;
+        }
+    }
+}
+
+bool RelationCollector::IsComplete() const { return relations_ >= target_; }
+
+size_t RelationCollector::GetRuns() const { return runs_; }
+
+const std::vector<std::vector<long_int>> & RelationCollector::GetProgress() const
+{
+    assert(file_);
+    return file_->GetProgress();
+}
+
+void RelationCollector::AddProgress(const std::vector<long_int> & progress)
+{
+    assert(file_);
+    file_->AddProgress(progress);
+}
+
+void RelationCollector::Flush()
+{
+    if (file_)
+    {
+        file_->Flush();
+    }
+}
+
+Solution RelationCollector::TakeSolution()
+{
+    StopVerifiers();
+    Flush();
+    for (auto & buffer : buffers_)
+    {
+        std::move(buffer.values.begin(), buffer.values.end(), std::back_inserter(solution_.values));
+        solution_.factors.Append(buffer.factors);
+        buffer.values.clear();
+        buffer.factors = Relations(prime_index_);
+    }
+    solution_.complete = IsComplete();
+    return std::move(solution_);
+}
+
+std::optional<std::pair<size_t, size_t>> RelationCollector::SplitCofactor(const long_int & rest) const
+{
+    // every prime below the largest factor base prime has been divided out, a cofactor below its square is prime
+    size_t bound = config_.large_prime_bound_;
+    if (rest < bound)
+    {
+        return std::make_pair(size_t(1), size_t(rest));
+    }
+    size_t max_prime = config_.primes_.back();
+    if (!config_.double_large_primes_ || rest < long_int(max_prime) * max_prime ||
+        rest >= long_int(bound) * bound || IsStrongPseudoPrime(rest, kPrimalityBases))
+    {
+        return std::nullopt;
+    }
+
+    FactorSet factor = RhoFactorization::Factorize(rest, 2);
+    if (factor.size() != 2)
+    {
+        return std::nullopt;
+    }
+    auto first = factor.begin()->first;
+    auto second = std::next(factor.begin())->first;
+    if (first >= bound || second >= bound)
     {
-        return sieve_.size();
+        return std::nullopt;
     }
-    return ((sieve_.size()) / threads) * (position + 1);
+    return std::minmax(size_t(first), size_t(second));
 }
 
 };  // namespace lpn
@@ -1,46 +1,221 @@
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <mutex>
 #include <optional>
+#include <random>
+#include <set>
+#include <thread>
+#include <unordered_set>
 
+#include "bounded_queue.hpp"
+#include "checkpoint.hpp"
 #include "gaussian.hpp"
 #include "base.hpp"
+#include "partial.hpp"
 
 namespace lpn
 {
 
+class SelfInitializingSieve;
+class RelationCollector;
+class DistributedSieve;
+class DistributedFactorization;
+class QuadraticSieveFactorization;
+
+// Sieve update of a prime larger than a block: its sieve entry, position inside the block and logarithm
+struct SieveUpdate
+{
+    uint32_t entry;
+    uint16_t offset;
+    uint8_t log;
+};
+
+// Cache sized part of the sieve interval [left, right); primes keep their next offsets between blocks
+class SieveBlock
+{
+   public:
+    explicit SieveBlock(size_t size);
+
+    void Reset(size_t left, size_t right);
+    void AddPrime(uint32_t & i, uint32_t & j, uint32_t p, uint8_t p_log);
+    void AddUpdates(const std::vector<SieveUpdate> & updates);
+    void FindCandidates(uint8_t threshold, std::vector<size_t> & candidates) const;
+
+   private:
+    static constexpr size_t kScanWidth = 64;
+
+    static uint64_t ComputeMask(const uint8_t * data, uint8_t threshold);
+
+    size_t left_;
+    size_t right_;
+    std::vector<uint8_t> data_;
+};
+
+// Primes larger than a block hit it at most once per root, so their hits over a window of consecutive blocks
+// are collected in one pass into per block buckets instead of visiting every prime in every block
+class BucketSieve
+{
+   public:
+    static constexpr size_t kDefWindowBlocks = 64;
+
+    explicit BucketSieve(size_t block_size, size_t blocks = kDefWindowBlocks);
+
+    void Reset(size_t left, size_t right);
+    void AddPrime(size_t entry, uint32_t & i, uint32_t & j, uint32_t p, uint8_t p_log);
+    const std::vector<SieveUpdate> & GetBucket(size_t block_left) const;
+    size_t GetWindowSize() const;
+
+   private:
+    void AddUpdate(size_t entry, size_t i, uint8_t p_log);
+
+    size_t block_shift_;
+    size_t left_;
+    size_t right_;
+    std::vector<std::vector<SieveUpdate>> buckets_;
+};
+
+// Sieve entries hitting the candidates of a sieved block, so that a candidate is divided only by the primes known to
+// divide it. Block primes are checked against their offsets, bucket updates are replayed over the candidate positions.
+class Resieve
+{
+   public:
+    explicit Resieve(size_t block_size);
+
+    void Reset(size_t left, const std::vector<size_t> & candidates);
+    void AddPrime(size_t entry, uint32_t i, uint32_t j, uint32_t p);
+    void AddUpdates(const std::vector<SieveUpdate> & updates);
+    const std::vector<uint32_t> & GetEntries(size_t candidate) const;
+
+   private:
+    size_t left_;
+    std::vector<size_t> candidates_;
+    // index of the candidate plus one for every position of the block, zero elsewhere
+    std::vector<uint16_t> marks_;
+    std::vector<std::vector<uint32_t>> entries_;
+};
+
+// Sieved values a * x^2 + b * x + c in floating point, used to follow the size of |f(x)| between blocks
+struct SieveFunction
+{
+    double ComputeMaxAbs(double left, double right) const;
+
+    double a;
+    double b;
+    double c;
+};
+
 class Sieve
 {
    private:
     struct BasicConfig
     {
-        static constexpr size_t kDefSegmentSize = 50'000'000;
-        static constexpr size_t kDefFactorSize = 2000;
-        static constexpr float kExpansionRate = 1.5;
+        static constexpr size_t kDefBlockSize = 32'768;
+        static constexpr size_t kDefSmallPrimeBound = 256;
+        static constexpr size_t kDefPrimePowerBound = 1'000'000;
+        static constexpr float kMaxLogValue = 200;
+        static constexpr size_t kMaxPrimePowerBound = size_t(1) << 31;
+        // square-free multipliers k tried for k * n and the bound of the primes in their Knuth-Schroeppel score
+        static constexpr std::array<size_t, 46> kMultipliers = {
+            1,  2,  3,  5,  6,  7,  10, 11, 13, 14, 15, 17, 19, 21, 22, 23, 26, 29, 30, 31, 33, 34, 35,
+            37, 38, 39, 41, 42, 43, 46, 47, 51, 53, 55, 57, 58, 59, 61, 62, 65, 66, 67, 69, 70, 71, 73};
+        static constexpr size_t kMultiplierPrimeBound = 1000;
+        // factor base size below which the parameter table eliminates incrementally, the larger ones use Gaussian
+        // elimination
+        static constexpr size_t kIncrementalFactorSize = 1000;
     };
 
+    // self-initializing sieve parameters by the number of decimal digits of n, interpolated between the rows
+    struct Parameters
+    {
+        size_t digits;
+        size_t factor_size;
+        size_t segment_size;
+        float expansion_rate;
+        size_t large_prime_multiplier;
+        bool double_large_primes;
+    };
+
+    static constexpr std::array<Parameters, 13> kParameters = {{
+        {30, 200, 32'768, 1.5, 0, false},
+        {35, 500, 65'536, 1.5, 0, false},
+        {40, 700, 65'536, 1.5, 0, false},
+        {45, 1000, 65'536, 1.3, 30, false},
+        {50, 2000, 65'536, 1.3, 30, false},
+        {55, 3000, 65'536, 1.3, 50, false},
+        {60, 4000, 98'304, 1.3, 50, false},
+        {65, 6000, 131'072, 1.3, 50, false},
+        {70, 10'000, 196'608, 1.3, 80, false},
+        {75, 18'000, 196'608, 1.3, 100, false},
+        {80, 30'000, 196'608, 1.3, 100, true},
+        {85, 45'000, 262'144, 1.3, 100, true},
+        {90, 60'000, 393'216, 1.3, 100, true},
+    }};
+
    public:
     struct Config
     {
         friend Sieve;
+        friend SelfInitializingSieve;
+        friend RelationCollector;
+        friend DistributedSieve;
+        friend DistributedFactorization;
+        friend QuadraticSieveFactorization;
+
+       public:
+        Config & SetLargePrimes(size_t multiplier, bool double_large_primes = false);
+        Config & SetSmallPrimeVariation(size_t small_prime_bound, size_t prime_power_bound = 0);
+        Config & SetCheckpoint(const std::string & path);
+        Config & SetLinearSolver(LinearSolver solver);
 
        private:
-        Config(size_t segment_size, size_t factor_size, bool multi_thread = false);
+        Config(const long_int & n, size_t segment_size, size_t factor_size, bool multi_thread = false,
+               bool self_initializing = false);
 
         void ComputeCloseness(float expansion);
+        uint8_t ComputeThreshold(const SieveFunction & function, double left, double right) const;
 
-        void Reserve();
-
+        void ComputeMultiplier(const long_int & n);
         void ComputeTarget(const long_int & n);
         void ComputePrimes(const long_int & n);
+        void ComputeSieveEntries();
+        void AddSieveEntry(size_t modulus, size_t root, uint8_t log, size_t position);
+        void SortSieveEntries();
+        void ComputeDivisors(const std::vector<uint32_t> & entries, std::vector<size_t> & divisors) const;
+
+        static size_t LiftRoot(const long_int & n, size_t root, size_t modulus);
 
+        // the sieved number k * n, the relations modulo k * n hold modulo n as well
+        long_int n_;
+        size_t multiplier_;
         size_t segment_size_;
+        size_t block_size_;
         size_t factor_size_;
         bool multi_thread_;
+        bool self_initializing_;
+        size_t large_prime_bound_;
+        bool double_large_primes_;
+        size_t small_prime_bound_;
+        size_t prime_power_bound_;
+        float small_primes_log_;
+        float expansion_rate_;
         float target_;
-        float closeness_;
+        float log_scale_;
+        uint8_t closeness_;
         std::vector<size_t> primes_;
-        std::vector<long_int> congruences_;
+        std::vector<uint32_t> congruences_;
+        // sieve plan, read-only and shared by all the sieves of a run: factor base primes from small_prime_bound_ and
+        // their powers up to prime_power_bound_ with their roots, logarithms and positions in primes_
+        std::vector<uint32_t> moduli_;
+        std::vector<uint32_t> roots_;
+        std::vector<uint8_t> logs_;
+        std::vector<uint32_t> positions_;
+        // entries from bucket_begin_ have moduli not less than block_size_ and go through the bucket sieve
+        size_t bucket_begin_;
+        // relation file of the run, empty when the relations are kept only in memory
+        std::string checkpoint_;
+        LinearSolver linear_solver_;
     };
 
    private:
@@ -51,20 +226,164 @@ class Sieve
     static Config CreateConfig(const long_int & n);
     static Config CreateConfig(const long_int & n, size_t segment_size, size_t factor_size, float expansion_rate,
                                bool multi_thread = false);
+    static Config CreateSelfInitializingConfig(const long_int & n);
+    static Config CreateSelfInitializingConfig(const long_int & n, size_t segment_size, size_t factor_size,
+                                               float expansion_rate, bool multi_thread = false);
 
    private:
-    void ComputeSieve(const Config & config, size_t left_border, size_t right_border);
-    void ComputeSieveMultiThread(const Config & config, const long_int & n);
-    Solution FindAllFactorizable(const Config & config, const long_int & n);
-    void AddFactor(const std::optional<FactorSet> & factor, size_t i, Solution & solution) const;
-    void AddPrimeInSieve(size_t i, size_t j, size_t p, size_t left_border, size_t right_border);
+    static Parameters ComputeParameters(const long_int & n);
+
+    void ComputeSieve(const Config & config, const long_int & n, size_t left_border, size_t right_border,
+                      RelationCollector & collector, size_t worker = 0);
+    Solution ComputeSieveMultiThread(const Config & config, const long_int & n);
+    std::vector<uint32_t> ComputeOffsets(const Config & config, size_t left_border) const;
+    void FindAllFactorizable(const Config & config, const long_int & n, const std::vector<size_t> & candidates,
+                             const Resieve & resieve, RelationCollector & collector, size_t worker);
     long_int ComputeTargetFunction(const long_int & n, size_t i) const;
-    size_t ComputeLeftBorder(size_t threads, size_t position) const;
-    size_t ComputeRightBorder(size_t threads, size_t position) const;
 
    private:
     const long_int r_;
-    std::vector<float> sieve_;
+    const size_t size_;
+    const SieveFunction function_;
+    // r mod q for every sieve entry, so that the offsets of any block are found in machine words
+    std::vector<uint32_t> residues_;
+};
+
+// Multiple polynomial sieve: Q(x) = (Ax + B)^2 - n, x in [-M, M), where A is a product of factor base primes
+// close to sqrt(2n) / M and the 2^(s-1) values of B for a single A are enumerated in Gray code order.
+class SelfInitializingSieve
+{
+    friend Sieve;
+    friend DistributedSieve;
+
+   private:
+    using Config = Sieve::Config;
+
+    struct BasicConfig
+    {
+        static constexpr size_t kMinFactorValue = 2000;
+        static constexpr size_t kMaxAttempts = 1000;
+        static constexpr size_t kSeed = 42;
+    };
+
+    SelfInitializingSieve(const long_int & n, const Config & config, size_t worker = 0);
+
+    static Solution Solve(const long_int & n, const Config & config);
+    static Solution SolveMultiThread(const long_int & n, const Config & config);
+
+    bool ChooseA();
+    void ChooseFactorsOfA(size_t amount, size_t left, size_t right);
+    bool ReplaceLastFactor(size_t left);
+    void InitializePolynomial();
+    void NextPolynomial(size_t index);
+    void ComputeFunction();
+    void SievePolynomials(RelationCollector & collector);
+    void ComputeSieve(RelationCollector & collector);
+    void FindAllFactorizable(RelationCollector & collector);
+    long_int ComputeValue(size_t i) const;
+
+   private:
+    const long_int n_;
+    const Config & config_;
+    const size_t worker_;
+    const size_t radius_;
+    const long_int a_target_;
+    SieveBlock block_;
+    BucketSieve buckets_;
+    Resieve resieve_;
+    std::vector<uint32_t> offsets_;
+    std::vector<size_t> candidates_;
+    std::vector<size_t> divisors_;
+    long_int a_;
+    long_int b_;
+    SieveFunction function_;
+    std::vector<size_t> a_factors_;
+    std::vector<long_int> b_terms_;
+    std::vector<uint32_t> first_roots_;
+    std::vector<uint32_t> second_roots_;
+    std::vector<std::vector<uint32_t>> b_inverse_;
+    std::vector<bool> is_a_factor_;
+    std::set<long_int> used_a_;
+    std::mt19937 gen_;
+};
+
+// Verifies sieve candidates by trial division over their resieved divisors, the sign of a negative f(x) is kept as the
+// factor -1. Full relations go into the buffer of the thread that verified them, relations with one or two large primes
+// below Config::large_prime_bound_ are combined by PartialRelations. With verifier threads started, the sieving threads
+// only push candidates into a bounded queue and the verification runs alongside the sieve. With a checkpoint every
+// accepted relation is also appended to a RelationFile, and the relations of the previous runs are replayed at the
+// start. With LinearSolver::kIncremental every relation goes to the solution under the lock and through
+// IncrementalSolver, the square root of a dependency is taken outside of the lock and the run is complete at the first
+// factor.
+class RelationCollector
+{
+   private:
+    using Config = Sieve::Config;
+
+    static inline const std::array<size_t, 4> kPrimalityBases = {2, 3, 5, 7};
+    static constexpr size_t kQueueSize = 1024;
+    static constexpr size_t kSieversPerVerifier = 3;
+
+   public:
+    RelationCollector(const long_int & n, const Config & config, size_t workers = 1);
+    ~RelationCollector();
+
+    void Add(const long_int & value, long_int rest, FactorSet factor, const std::vector<size_t> & divisors,
+             size_t worker = 0);
+    bool IsComplete() const;
+    size_t GetRuns() const;
+    // progress marks of the previous runs, a mark is appended and flushed with the relations found before it
+    const std::vector<std::vector<long_int>> & GetProgress() const;
+    void AddProgress(const std::vector<long_int> & progress);
+    void Flush();
+    Solution TakeSolution();
+
+    static size_t GetVerifierAmount(size_t threads);
+    void StartVerifiers(size_t verifiers);
+    void StopVerifiers();
+
+   private:
+    struct alignas(64) Buffer
+    {
+        std::vector<long_int> values;
+        Relations factors;
+    };
+
+    struct Candidate
+    {
+        long_int value;
+        long_int rest;
+        FactorSet factor;
+        std::vector<size_t> divisors;
+    };
+
+    void Verify(const long_int & value, long_int rest, FactorSet factor, const std::vector<size_t> & divisors,
+                size_t buffer);
+    void RunVerifier(size_t buffer);
+    void LoadCheckpoint();
+    void UpdateIncremental(std::unique_lock<std::mutex> & lock);
+    std::optional<std::pair<size_t, size_t>> SplitCofactor(const long_int & rest) const;
+
+   private:
+    const long_int n_;
+    const Config & config_;
+    const size_t target_;
+    const size_t workers_;
+    std::atomic<size_t> relations_;
+    // the factor base index shared by the buffers
+    const std::shared_ptr<const Relations::PrimeIndex> prime_index_;
+    std::vector<Buffer> buffers_;
+    std::mutex mutex_;
+    Solution solution_;
+    PartialRelations partials_;
+    // keys of the full relations, see PartialRelations::ComputeKey
+    std::unordered_set<long_int> full_values_;
+    BoundedQueue<Candidate> queue_;
+    std::vector<std::thread> verifiers_;
+    std::atomic<bool> stop_;
+    std::unique_ptr<RelationFile> file_;
+    size_t runs_;
+    std::unique_ptr<IncrementalSolver> incremental_;
 };
 
 class QuadraticSieveFactorization : private FactorizationBase
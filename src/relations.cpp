@@ -0,0 +1,153 @@
+#include "relations.hpp"
+
+#include <cassert>
+
+namespace lpn
+{
+
+std::shared_ptr<const Relations::PrimeIndex> Relations::CreateIndex(const std::vector<size_t> & primes)
+{
+    auto index = std::make_shared<PrimeIndex>();
+    index->primes = primes;
+    for (size_t pos = 0; pos < primes.size(); ++pos)
+    {
+        index->indices[primes[pos]] = uint32_t(pos);
+    }
+    return index;
+}
+
+Relations::Relations(const std::vector<size_t> & primes) : Relations(CreateIndex(primes)) {}
+
+Relations::Relations(std::shared_ptr<const PrimeIndex> index)
+    : base_size_(index->primes.size()), index_(std::move(index))
+{
+}
+
+Relations::Relations(const std::vector<size_t> & primes, const FactorSets & factors) : Relations(primes)
+{
+    for (const auto & factor : factors)
+    {
+        Add(factor);
+    }
+}
+
+void Relations::Add(const FactorSet & factor)
+{
+    for (const auto & [prime, power] : factor)
+    {
+        if (power == 0)
+        {
+            continue;
+        }
+        AddEntry(prime < 0 ? kSign : GetIndex(size_t(prime)), power);
+    }
+    offsets_.push_back(uint32_t(entries_.size()));
+}
+
+void Relations::Add(const std::vector<uint32_t> & indices)
+{
+    for (auto index : indices)
+    {
+        AddEntry(index, 1);
+    }
+    offsets_.push_back(uint32_t(entries_.size()));
+}
+
+void Relations::Append(const Relations & relations)
+{
+    assert(relations.base_size_ == base_size_);
+    for (size_t relation = 0; relation < relations.Size(); ++relation)
+    {
+        AddRelation(relations, relation);
+    }
+}
+
+Relations Relations::Select(const std::vector<size_t> & relations) const
+{
+    Relations selected;
+    selected.base_size_ = base_size_;
+    selected.index_ = index_;
+    for (auto relation : relations)
+    {
+        selected.AddRelation(*this, relation);
+    }
+    return selected;
+}
+
+size_t Relations::Size() const { return offsets_.size() - 1; }
+
+size_t Relations::GetBaseSize() const { return base_size_; }
+
+size_t Relations::GetPrimeAmount() const { return base_size_ + large_primes_.size(); }
+
+size_t Relations::GetPrime(uint32_t index) const
+{
+    return index < base_size_ ? index_->primes[index] : large_primes_[index - base_size_];
+}
+
+std::span<const uint32_t> Relations::GetIndices(size_t relation) const
+{
+    return {entries_.data() + offsets_[relation], entries_.data() + offsets_[relation + 1]};
+}
+
+std::span<const uint8_t> Relations::GetPowers(size_t relation) const
+{
+    return {powers_.data() + offsets_[relation], powers_.data() + offsets_[relation + 1]};
+}
+
+FactorSet Relations::GetFactor(size_t relation) const
+{
+    FactorSet factor;
+    auto indices = GetIndices(relation);
+    auto powers = GetPowers(relation);
+    for (size_t k = 0; k < indices.size(); ++k)
+    {
+        factor[indices[k] == kSign ? long_int(-1) : long_int(GetPrime(indices[k]))] += powers[k];
+    }
+    return factor;
+}
+
+uint32_t Relations::GetIndex(size_t prime)
+{
+    if (index_)
+    {
+        auto iter = index_->indices.find(prime);
+        if (iter != index_->indices.end())
+        {
+            return iter->second;
+        }
+    }
+    auto [iter, inserted] = large_indices_.try_emplace(prime, uint32_t(GetPrimeAmount()));
+    if (inserted)
+    {
+        large_primes_.push_back(prime);
+    }
+    return iter->second;
+}
+
+void Relations::AddRelation(const Relations & relations, size_t relation)
+{
+    auto indices = relations.GetIndices(relation);
+    auto powers = relations.GetPowers(relation);
+    for (size_t k = 0; k < indices.size(); ++k)
+    {
+        uint32_t index = indices[k];
+        if (index != kSign && index >= base_size_)
+        {
+            index = GetIndex(relations.GetPrime(index));
+        }
+        AddEntry(index, powers[k]);
+    }
+    offsets_.push_back(uint32_t(entries_.size()));
+}
+
+void Relations::AddEntry(uint32_t index, size_t power)
+{
+    for (; power > 0; power -= std::min(power, kMaxPower))
+    {
+        entries_.push_back(index);
+        powers_.push_back(uint8_t(std::min(power, kMaxPower)));
+    }
+}
+
+};  // namespace lpn
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "aliases.hpp"
+
+#include <memory>
+#include <span>
+#include <unordered_map>
+
+namespace lpn
+{
+
+// Relations packed into one arena of (prime index, exponent) pairs: the pairs of the relation i are the entries from
+// offsets_[i] to offsets_[i + 1]. The factor base primes are indices 0 .. GetBaseSize() - 1, the sign is kSign and the
+// primes outside of the factor base (the large primes of combined partial relations) get the next indices as they
+// are added. An exponent above kMaxPower takes several entries of the same index. The factor base and its prime to
+// index map are immutable and shared by the relations built from the same PrimeIndex, the large primes are per object.
+class Relations
+{
+   public:
+    static constexpr uint32_t kSign = UINT32_MAX;
+    static constexpr size_t kMaxPower = UINT8_MAX;
+
+    struct PrimeIndex
+    {
+        std::vector<size_t> primes;
+        std::unordered_map<size_t, uint32_t> indices;
+    };
+
+    static std::shared_ptr<const PrimeIndex> CreateIndex(const std::vector<size_t> & primes);
+
+    Relations() = default;
+    explicit Relations(const std::vector<size_t> & primes);
+    explicit Relations(std::shared_ptr<const PrimeIndex> index);
+    Relations(const std::vector<size_t> & primes, const FactorSets & factors);
+
+    void Add(const FactorSet & factor);
+    // a relation with the exponent 1 of every index
+    void Add(const std::vector<uint32_t> & indices);
+    // relations over the same factor base
+    void Append(const Relations & relations);
+    // a copy of the given relations sharing the factor base index
+    Relations Select(const std::vector<size_t> & relations) const;
+
+    size_t Size() const;
+    size_t GetBaseSize() const;
+    // factor base and large primes, the indices of the entries without kSign
+    size_t GetPrimeAmount() const;
+    size_t GetPrime(uint32_t index) const;
+
+    std::span<const uint32_t> GetIndices(size_t relation) const;
+    std::span<const uint8_t> GetPowers(size_t relation) const;
+    FactorSet GetFactor(size_t relation) const;
+
+   private:
+    uint32_t GetIndex(size_t prime);
+    void AddEntry(uint32_t index, size_t power);
+    void AddRelation(const Relations & relations, size_t relation);
+
+   private:
+    size_t base_size_ = 0;
+    std::shared_ptr<const PrimeIndex> index_;
+    std::vector<size_t> large_primes_;
+    std::unordered_map<size_t, uint32_t> large_indices_;
+    std::vector<uint32_t> offsets_ = {0};
+    std::vector<uint32_t> entries_;
+    std::vector<uint8_t> powers_;
+};
+
+};  // namespace lpn
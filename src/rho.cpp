@@ -1,8 +1,34 @@
 #include "rho.hpp"
+#include "montgomery.hpp"
 
 namespace lpn
 {
 
+RhoFactorization::LongField::LongField(const long_int & n) : n_(n), one_(1) {}
+
+RhoFactorization::LongField::Number RhoFactorization::LongField::Convert(const long_int & x) const { return x; }
+
+const RhoFactorization::LongField::Number & RhoFactorization::LongField::GetOne() const { return one_; }
+
+RhoFactorization::LongField::Number RhoFactorization::LongField::Add(const Number & a, const Number & b) const
+{
+    return (a + b) % n_;
+}
+
+RhoFactorization::LongField::Number RhoFactorization::LongField::Subtract(const Number & a, const Number & b) const
+{
+    return abs(a - b);
+}
+
+RhoFactorization::LongField::Number RhoFactorization::LongField::Multiply(const Number & a, const Number & b) const
+{
+    return (a * b) % n_;
+}
+
+bool RhoFactorization::LongField::IsZero(const Number & a) { return a == 0; }
+
+long_int RhoFactorization::LongField::Gcd(const Number & a) const { return lpn::gcd(n_, a); }
+
 FactorSet RhoFactorization::Factorize(const long_int & n, size_t starting_point)
 {
     return RhoFactorization().FindFactor(n, starting_point);
@@ -28,13 +54,50 @@ RhoFactorization::RhoFactorization(const long_int & c, size_t max_iter, size_t f
 }
 
 FactorSet RhoFactorization::FindFactor(const long_int & n, size_t starting_point)
+{
+    if (n % 2 == 0 || n < 3)
+    {
+        return FindFactor(LongField(n), n, starting_point);
+    }
+    size_t bits = msb(n) + 1;
+    if (bits <= 64)
+    {
+        return FindFactor(Montgomery<1>(n), n, starting_point);
+    }
+    if (bits <= 128)
+    {
+        return FindFactor(Montgomery<2>(n), n, starting_point);
+    }
+    if (bits <= 192)
+    {
+        return FindFactor(Montgomery<3>(n), n, starting_point);
+    }
+    if (bits <= 256)
+    {
+        return FindFactor(Montgomery<4>(n), n, starting_point);
+    }
+    if (bits <= 512)
+    {
+        return FindFactor(Montgomery<8>(n), n, starting_point);
+    }
+    return FindFactor(LongField(n), n, starting_point);
+}
+
+template <typename Field>
+FactorSet RhoFactorization::FindFactor(const Field & field, const long_int & n, size_t starting_point)
 {
     FactorSet factor;
-    long_int x1 = starting_point;
+    if (IsPseudoPrime(n, BasicConfig::kPrimes))
+    {
+        factor[n] = 1;
+        return factor;
+    }
+    auto c = field.Convert(c_);
+    auto x1 = field.Convert(starting_point);
 
     for (size_t i = 0; i < max_attemp_; ++i)
     {
-        long_int divisor = FindDivisor(n, x1);
+        long_int divisor = FindDivisor(field, c, n, x1);
         if (divisor != 1 && divisor != n)
         {
             factor[divisor] += 1;
@@ -48,31 +111,33 @@ FactorSet RhoFactorization::FindFactor(const long_int & n, size_t starting_point
 
 size_t RhoFactorization::ComputeNextRange(size_t range) const { return range << 1; }
 
-void RhoFactorization::UpdateX1(const long_int & x2, long_int & x1) { x1 = x2; }
-
-void RhoFactorization::UpdateX2(const long_int & n, size_t range, long_int & x2)
+template <typename Field>
+void RhoFactorization::UpdateX2(const Field & field, const typename Field::Number & c, size_t range,
+                                typename Field::Number & x2) const
 {
     for (size_t j = 0; j < range; ++j)
     {
-        x2 = Next(x2, n);
+        x2 = Next(field, c, x2);
     }
 }
 
-std::optional<long_int> RhoFactorization::TryToFindDivisor(const long_int & n, size_t range, size_t terms,
-                                                           long_int & x1, long_int & x2)
+template <typename Field>
+std::optional<long_int> RhoFactorization::TryToFindDivisor(const Field & field, const typename Field::Number & c,
+                                                           size_t range, size_t terms, typename Field::Number & x1,
+                                                           typename Field::Number & x2) const
 {
-    long_int product = 1;
+    auto product = field.GetOne();
     long_int divisor = 1;
     for (size_t j = 0; j < range; ++j)
     {
-        x2 = Next(x2, n);
-        product = (product * abs(x1 - x2)) % n;
-        if (product == 0)
+        x2 = Next(field, c, x2);
+        product = field.Multiply(product, field.Subtract(x1, x2));
+        if (Field::IsZero(product))
         {
-            product = 1;
+            product = field.GetOne();
         }
         terms++;
-        if ((terms % frequency_ == 0 || j + 1 == range) && ((divisor = lpn::gcd(n, product)) > 1))
+        if ((terms % frequency_ == 0 || j + 1 == range) && ((divisor = field.Gcd(product)) > 1))
         {
             return divisor;
         }
@@ -80,26 +145,33 @@ std::optional<long_int> RhoFactorization::TryToFindDivisor(const long_int & n, s
     return std::nullopt;
 }
 
-long_int RhoFactorization::FindDivisor(const long_int & n, long_int & x1)
+template <typename Field>
+long_int RhoFactorization::FindDivisor(const Field & field, const typename Field::Number & c, const long_int & n,
+                                       typename Field::Number & x1) const
 {
-    long_int x2 = Next(x1, n);
+    auto x2 = Next(field, c, x1);
     size_t range = 1;
     size_t terms = 0;
-    while (terms <= max_iter_ && !IsPseudoPrime(n, BasicConfig::kPrimes))
+    while (terms <= max_iter_)
     {
-        auto divisor = TryToFindDivisor(n, range, terms, x1, x2);
+        auto divisor = TryToFindDivisor(field, c, range, terms, x1, x2);
         if (divisor.has_value())
         {
             return divisor.value();
         }
         terms += range;
         range = ComputeNextRange(range);
-        UpdateX1(x2, x1);
-        UpdateX2(n, range, x2);
+        x1 = x2;
+        UpdateX2(field, c, range, x2);
     }
     return n;
 }
 
-long_int RhoFactorization::Next(const long_int & x2, const long_int & n) const { return (x2 * x2 + c_) % n; }
+template <typename Field>
+typename Field::Number RhoFactorization::Next(const Field & field, const typename Field::Number & c,
+                                              const typename Field::Number & x2)
+{
+    return field.Add(field.Multiply(x2, x2), c);
+}
 
 };  // namespace lpn
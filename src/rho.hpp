@@ -7,6 +7,9 @@
 namespace lpn
 {
 
+// Pollard's rho with Brent's cycle search. An odd n of up to 512 bits is iterated in Montgomery<N> of the smallest
+// width that holds it, the others in long_int; the iterations go over the same residues in both, so the divisor found
+// does not depend on the arithmetic.
 class RhoFactorization
 {
    private:
@@ -19,6 +22,28 @@ class RhoFactorization
         static constexpr size_t kDefMaxAttempValue = 100;
     };
 
+    // the arithmetic modulo n of long_int with the interface of Montgomery
+    class LongField
+    {
+       public:
+        using Number = long_int;
+
+        explicit LongField(const long_int & n);
+
+        Number Convert(const long_int & x) const;
+        const Number & GetOne() const;
+        Number Add(const Number & a, const Number & b) const;
+        // the distance, the sign does not change the divisors
+        Number Subtract(const Number & a, const Number & b) const;
+        Number Multiply(const Number & a, const Number & b) const;
+        static bool IsZero(const Number & a);
+        long_int Gcd(const Number & a) const;
+
+       private:
+        long_int n_;
+        long_int one_;
+    };
+
    public:
     static FactorSet Factorize(const long_int & n, size_t starting_point);
     static FactorSet Factorize(const long_int & n, const long_int & c, size_t max_iter, size_t frequency,
@@ -31,13 +56,22 @@ class RhoFactorization
    private:
     FactorSet FindFactor(const long_int & n, size_t starting_point);
     size_t ComputeNextRange(size_t range) const;
-    void UpdateX1(const long_int & x2, long_int & x1);
-    void UpdateX2(const long_int & n, size_t range, long_int & x2);
-    std::optional<long_int> TryToFindDivisor(const long_int & n, size_t terms, size_t range, long_int & x1,
-                                             long_int & x2);
 
-    long_int FindDivisor(const long_int & n, long_int & x1);
-    long_int Next(const long_int & x2, const long_int & n) const;
+    template <typename Field>
+    FactorSet FindFactor(const Field & field, const long_int & n, size_t starting_point);
+    template <typename Field>
+    void UpdateX2(const Field & field, const typename Field::Number & c, size_t range,
+                  typename Field::Number & x2) const;
+    template <typename Field>
+    std::optional<long_int> TryToFindDivisor(const Field & field, const typename Field::Number & c, size_t range,
+                                             size_t terms, typename Field::Number & x1,
+                                             typename Field::Number & x2) const;
+    template <typename Field>
+    long_int FindDivisor(const Field & field, const typename Field::Number & c, const long_int & n,
+                         typename Field::Number & x1) const;
+    template <typename Field>
+    static typename Field::Number Next(const Field & field, const typename Field::Number & c,
+                                       const typename Field::Number & x2);
 
     const long_int c_;
     const size_t max_iter_;
@@ -137,6 +137,21 @@ TEST(Basic, StrongPseudoPrimeTest)
     ASSERT_EQ(IsStrongPseudoPrime(value, primes), false);
 }
 
+TEST(Basic, SievePrimes)
+{
+    std::vector<size_t> primes = SievePrimes(1, 200'000);
+    ASSERT_EQ(primes.size(), 17'983);  // pi(200000) - 1 for the prime 2
+    for (size_t p = 3, i = 0; p < 200'000; p += 2)
+    {
+        if (IsPrimeBasic(p))
+        {
+            ASSERT_EQ(primes[i++], p);
+        }
+    }
+    ASSERT_EQ(SievePrimes(1'000'000, 1'000'100), std::vector<size_t>({1'000'003, 1'000'033, 1'000'037, 1'000'039,
+                                                                     1'000'081, 1'000'099}));
+}
+
 TEST(Factorization, BasicComplex)
 {
     long_int value("1307674368000");
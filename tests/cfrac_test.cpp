@@ -23,4 +23,26 @@ TEST(CFRAC, ContinuedFractionsWithConfig)
     ASSERT_EQ(Eval(factor), n);
 }
 
+TEST(CFRAC, RelationsKeepSign)
+{
+    long_int n("106456777608740439414017801971");  // 341727233806069 * 311525588473159
+    Solution solution = ContinuedFractions::Solve(n, 200);
+    size_t negative = 0;
+    for (size_t i = 0; i < solution.values.size(); ++i)
+    {
+        negative += solution.factors.GetFactor(i).contains(-1);
+        ASSERT_EQ((solution.values[i] * solution.values[i] - Eval(solution.factors.GetFactor(i))) % n, 0);
+    }
+    ASSERT_GT(negative, 0);
+}
+
+TEST(CFRAC, IncrementalStopsEarly)
+{
+    long_int n("106456777608740439414017801971");  // 341727233806069 * 311525588473159
+    Solution solution = ContinuedFractions::Solve(n, 200, "", LinearSolver::kIncremental);
+    ASSERT_EQ(solution.factor.size(), 2);
+    ASSERT_EQ(Eval(solution.factor), n);
+    ASSERT_LT(solution.factors.Size(), solution.primes.size());
+}
+
 };  // namespace
@@ -0,0 +1,146 @@
+#include "cfrac.hpp"
+#include "checkpoint.hpp"
+#include "qs.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+
+using namespace lpn;  // NOLINT
+
+std::string GetPath(const std::string & name)
+{
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+TEST(RelationFile, StoresRelationsAndProgress)
+{
+    std::string path = GetPath("lpn_relation_file.bin");
+    long_int n = 1'000'003;
+    std::vector<size_t> primes = {2, 3, 5, 7};
+    {
+        RelationFile file(path, n, primes);
+        ASSERT_TRUE(file.GetRelations().empty());
+        file.AddRelation({10, {{2, 1}, {5, 1}}});
+        file.AddRelation({long_int("123456789012345678901234567890"), {{3, 2}, {101, 1}}, 1, 101});
+        file.AddProgress({7, long_int("98765432109876543210")});
+    }
+
+    RelationFile file(path, n, primes);
+    ASSERT_EQ(file.GetRelations().size(), 2);
+    ASSERT_EQ(file.GetRelations()[0].value, 10);
+    ASSERT_EQ(file.GetRelations()[0].factor, FactorSet({{2, 1}, {5, 1}}));
+    ASSERT_EQ(file.GetRelations()[0].second, 1);
+    ASSERT_EQ(file.GetRelations()[1].factor, FactorSet({{3, 2}, {101, 1}}));
+    ASSERT_EQ(file.GetRelations()[1].second, 101);
+    ASSERT_TRUE(file.Contains(long_int("123456789012345678901234567890")));
+    ASSERT_EQ(file.GetProgress().size(), 1);
+    ASSERT_EQ(file.GetProgress()[0][1], long_int("98765432109876543210"));
+}
+
+TEST(RelationFile, DropsTornRecord)
+{
+    std::string path = GetPath("lpn_relation_file_torn.bin");
+    long_int n = 1'000'003;
+    std::vector<size_t> primes = {2, 3, 5, 7};
+    {
+        RelationFile file(path, n, primes);
+        file.AddRelation({10, {{2, 1}, {5, 1}}});
+        file.AddRelation({21, {{3, 1}, {7, 1}}});
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    {
+        RelationFile file(path, n, primes);
+        ASSERT_EQ(file.GetRelations().size(), 1);
+        file.AddRelation({15, {{3, 1}, {5, 1}}});
+    }
+
+    RelationFile file(path, n, primes);
+    ASSERT_EQ(file.GetRelations().size(), 2);
+    ASSERT_EQ(file.GetRelations()[1].value, 15);
+}
+
+TEST(RelationFile, DropsUnknownRecord)
+{
+    std::string path = GetPath("lpn_relation_file_unknown.bin");
+    long_int n = 1'000'003;
+    std::vector<size_t> primes = {2, 3, 5, 7};
+    size_t size;
+    {
+        RelationFile file(path, n, primes);
+        file.AddRelation({10, {{2, 1}, {5, 1}}});
+        file.Flush();
+        size = std::filesystem::file_size(path);
+        file.AddRelation({21, {{3, 1}, {7, 1}}});
+    }
+    // the second record gets a type byte that is neither a relation nor a progress mark
+    {
+        std::fstream output(path, std::ios::binary | std::ios::in | std::ios::out);
+        output.seekp(std::streamoff(size));
+        output.put(char(7));
+    }
+    {
+        RelationFile file(path, n, primes);
+        ASSERT_EQ(file.GetRelations().size(), 1);
+        file.AddRelation({15, {{3, 1}, {5, 1}}});
+    }
+
+    RelationFile file(path, n, primes);
+    ASSERT_EQ(file.GetRelations().size(), 2);
+    ASSERT_EQ(file.GetRelations()[1].value, 15);
+}
+
+TEST(RelationFile, StartsOverForOtherNumber)
+{
+    std::string path = GetPath("lpn_relation_file_other.bin");
+    std::vector<size_t> primes = {2, 3, 5, 7};
+    {
+        RelationFile file(path, 1'000'003, primes);
+        file.AddRelation({10, {{2, 1}, {5, 1}}});
+    }
+    RelationFile file(path, 1'000'033, primes);
+    ASSERT_TRUE(file.GetRelations().empty());
+}
+
+TEST(RelationFile, ResumesSelfInitializingSieve)
+{
+    std::string path = GetPath("lpn_relation_file_qs.bin");
+    long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+    // every run collects all the relations, the incremental solver would stop each of them at its first factor
+    auto config = Sieve::CreateSelfInitializingConfig(n).SetCheckpoint(path).SetLinearSolver(LinearSolver::kGaussian);
+    Solution solution = Sieve::Solve(n, config);
+
+    // a run killed half way through
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+
+    // a complete file goes straight to the linear algebra
+    Solution resumed = Sieve::Solve(n, config);
+    ASSERT_GE(resumed.values.size(), solution.values.size());
+}
+
+TEST(RelationFile, ResumesContinuedFractions)
+{
+    std::string path = GetPath("lpn_relation_file_cfrac.bin");
+    long_int n("106456777608740439414017801971");  // 341727233806069 * 311525588473159
+    Solution solution = ContinuedFractions::Solve(n, 200, path);
+
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) * 2 / 3);
+    FactorSet factor = ContinuedFractionsFactorization::Factorize(n, 200, path);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+
+    Solution resumed = ContinuedFractions::Solve(n, 200, path);
+    ASSERT_EQ(resumed.values.size(), solution.values.size());
+    ASSERT_EQ(std::set<long_int>(resumed.values.begin(), resumed.values.end()).size(), resumed.values.size());
+}
+
+};  // namespace
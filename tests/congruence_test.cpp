@@ -129,4 +129,49 @@ TEST(Sieve, QuadraticCongruencesHeavy)
     }
 }
 
+TEST(Sieve, QuadraticCongruencesWord)
+{
+    boost::mt19937 rng(42);
+    std::vector<size_t> primes = SievePrimes(3, 20'000);
+    std::vector<size_t> large = SievePrimes(4'294'960'000, 4'294'967'296);  // up to 2^32
+    primes.insert(primes.end(), large.begin(), large.end());
+    for (uint64_t p : primes)
+    {
+        uint64_t value = uint64_t(rng()) % p;
+        ASSERT_EQ(ComputeLegendreSymbol(value, p), ComputeLegendreSymbol(long_int(value), long_int(p)));
+        value = value * value % p;
+        uint64_t root = QuadraticCongruences::Solve(value, p);
+        ASSERT_LT(root, p);
+        ASSERT_EQ(root * root % p, value);
+    }
+}
+
+TEST(Sieve, FactorBase)
+{
+    long_int n("59469489332848408438249254427481121839977");
+    FactorBase base = ComputeFactorBase(n, 50'000);
+    ASSERT_EQ(base.primes.size(), 50'000);
+    ASSERT_EQ(base.primes[0], 2);
+    for (size_t i = 1; i < base.primes.size(); ++i)
+    {
+        ASSERT_LT(base.primes[i - 1], base.primes[i]);
+        long_int p = base.primes[i];
+        ASSERT_EQ((long_int(base.roots[i]) * base.roots[i] - n) % p, 0);
+    }
+    ASSERT_EQ(FindQuadraticResiduePrimes(n, 100).size(), 101);
+}
+
+TEST(Sieve, QuadraticResiduePrimesSkipDivisors)
+{
+    long_int n = long_int(3 * 5 * 7 * 11) * 1'000'003;
+    std::vector<size_t> primes = FindQuadraticResiduePrimes(n, 20);
+    ASSERT_EQ(primes.size(), 21);
+    ASSERT_EQ(primes[0], 2);
+    for (size_t i = 1; i < primes.size(); ++i)
+    {
+        ASSERT_NE(n % primes[i], 0);
+        ASSERT_TRUE(IsQuadraticResidue(n, primes[i]));
+    }
+}
+
 }  // namespace
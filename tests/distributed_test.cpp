@@ -0,0 +1,105 @@
+#include "distributed.hpp"
+
+#include <gtest/gtest.h>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+
+using namespace lpn;  // NOLINT
+
+std::string GetDirectory(const std::string & name)
+{
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(path);
+    std::filesystem::create_directories(path);
+    return path.string();
+}
+
+std::vector<pid_t> StartWorkers(const Sieve::Config & config, const std::string & directory, size_t workers)
+{
+    std::vector<pid_t> children;
+    for (size_t worker = 0; worker < workers; ++worker)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            DistributedSieve::RunWorker(config, directory, worker, workers);
+            _exit(0);
+        }
+        children.push_back(pid);
+    }
+    return children;
+}
+
+void WaitWorkers(const std::vector<pid_t> & children)
+{
+    for (pid_t pid : children)
+    {
+        int status;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+    }
+}
+
+const long_int kNumber("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+
+TEST(DistributedSieve, FactorizeWithWorkerProcesses)
+{
+    std::string directory = GetDirectory("lpn_distributed");
+    Sieve::Config config = Sieve::CreateConfig(kNumber);
+    const size_t workers = 3;
+
+    auto children = StartWorkers(config, directory, workers);
+    ASSERT_EQ(children.size(), workers);
+    FactorSet factor = DistributedFactorization::Factorize(kNumber, config, directory, workers);
+    WaitWorkers(children);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), kNumber);
+}
+
+TEST(DistributedSieve, RerunOverExistingDirectory)
+{
+    std::string directory = GetDirectory("lpn_distributed_rerun");
+    Sieve::Config config = Sieve::CreateConfig(kNumber);
+    const size_t workers = 2;
+
+    // an interrupted run: the workers are killed, and the stop and done files of a finished one are left over
+    auto killed = StartWorkers(config, directory, workers);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    for (pid_t pid : killed)
+    {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+    std::ofstream(std::filesystem::path(directory) / "stop");
+    for (size_t worker = 0; worker < workers; ++worker)
+    {
+        std::ofstream(std::filesystem::path(directory) / ("done." + std::to_string(worker)));
+    }
+
+    auto children = StartWorkers(config, directory, workers);
+    FactorSet factor = DistributedFactorization::Factorize(kNumber, config, directory, workers);
+    WaitWorkers(children);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), kNumber);
+}
+
+TEST(DistributedSieve, StalledCollection)
+{
+    std::string directory = GetDirectory("lpn_distributed_stalled");
+    Sieve::Config config = Sieve::CreateConfig(kNumber);
+    // no worker is started, so no relation file ever grows
+    auto timeout = std::chrono::milliseconds(200);
+    ASSERT_FALSE(DistributedSieve::RunCoordinator(kNumber, config, directory, 2, timeout).has_value());
+    ASSERT_EQ(DistributedFactorization::Factorize(kNumber, config, directory, 2, timeout), FactorSet({{kNumber, 1}}));
+}
+
+};  // namespace
@@ -0,0 +1,117 @@
+#include "filter.hpp"
+#include "lanczos.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+
+using namespace lpn;  // NOLINT
+
+// the relations take the first primes_size primes, the extra primes are only in the factor base
+Solution CreateSolution(size_t primes_size, size_t relations, size_t seed, const std::vector<size_t> & extra = {})
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::vector<size_t> primes = SievePrimes(3, 100'000);
+    primes.resize(primes_size);
+    primes.insert(primes.end(), extra.begin(), extra.end());
+    Solution solution(primes);
+    for (size_t i = 0; i < relations; ++i)
+    {
+        FactorSet factor;
+        for (size_t j = 0; j < 6; ++j)
+        {
+            factor[solution.primes[gen() % 30]] += 1;
+        }
+        // large primes are rare in the relations, as they are in the sieved values
+        for (size_t j = 0; j < 10; ++j)
+        {
+            double position = uniform(gen);
+            factor[solution.primes[size_t(position * position * primes_size)]] += 1;
+        }
+        if (gen() % 2 == 0)
+        {
+            factor[-1] = 1;
+        }
+        solution.values.push_back(i + 1);
+        solution.factors.Add(factor);
+    }
+    return solution;
+}
+
+// the dependencies of the reduced relations expanded to the relations of the solution
+std::vector<GaussianBasic::Dependency> Expand(const RelationFilter & filter,
+                                             const std::vector<GaussianBasic::Dependency> & dependencies)
+{
+    std::vector<GaussianBasic::Dependency> expanded;
+    for (const auto & dependency : dependencies)
+    {
+        expanded.push_back(filter.Expand(dependency));
+    }
+    return expanded;
+}
+
+void CheckSquares(const Solution & solution, const std::vector<GaussianBasic::Dependency> & dependencies)
+{
+    for (const auto & dependency : dependencies)
+    {
+        ASSERT_FALSE(dependency.empty());
+        FactorSet product;
+        for (auto i : dependency)
+        {
+            ASSERT_LT(i, solution.factors.Size());
+            MergeFactorSets(product, solution.factors.GetFactor(i));
+        }
+        for (const auto & [prime, power] : product)
+        {
+            ASSERT_EQ(power % 2, 0);
+        }
+    }
+}
+
+TEST(RelationFilter, Shrinks)
+{
+    Solution solution = CreateSolution(2000, 2400, 42);
+    RelationFilter filter(solution);
+    ASSERT_LT(filter.GetFactors().Size(), solution.factors.Size() * 3 / 4);
+    ASSERT_LT(filter.GetPrimes().size(), filter.GetFactors().Size());
+
+    auto dependencies = Expand(filter, BlockLanczos(filter.GetFactors()).Solve());
+    ASSERT_GE(dependencies.size(), 10);
+    CheckSquares(solution, dependencies);
+}
+
+TEST(RelationFilter, DuplicatesAndSingletons)
+{
+    Solution solution = CreateSolution(300, 320, 7, {1'000'003});
+    // a copy of a relation and a relation with a prime found nowhere else
+    solution.values.push_back(solution.values[5]);
+    solution.factors.Add(solution.factors.GetFactor(5));
+    solution.values.push_back(solution.values.size() + 1);
+    solution.factors.Add({{1'000'003, 1}, {3, 1}});
+
+    RelationFilter filter(solution);
+    ASSERT_TRUE(std::find(filter.GetPrimes().begin(), filter.GetPrimes().end(), 1'000'003) == filter.GetPrimes().end());
+    for (size_t i = 0; i < filter.GetFactors().Size(); ++i)
+    {
+        ASSERT_FALSE(filter.GetFactors().GetFactor(i).contains(1'000'003));
+    }
+    GaussianBasic gaussian(filter.GetFactors());
+    gaussian.Solve();
+    std::vector<GaussianBasic::Dependency> dependencies;
+    while (auto dependency = gaussian.NextDependency())
+    {
+        dependencies.push_back(filter.Expand(dependency.value()));
+    }
+    ASSERT_FALSE(dependencies.empty());
+    CheckSquares(solution, dependencies);
+    for (const auto & dependency : dependencies)
+    {
+        ASSERT_LT(dependency.back(), solution.values.size() - 2);
+    }
+}
+
+};  // namespace
@@ -1,14 +1,26 @@
 #include "gaussian.hpp"
 #include "basic.hpp"
 #include "gtest/gtest.h"
-#include "boost/random.hpp"
+#include "thread_group.hpp"
+
+#include <random>
 
 namespace
 {
 
 using namespace lpn;  // NOLINT
 
-TEST(GaussianBasic, mask)
+bool IsSquare(const std::vector<FactorSet> & factors, const GaussianBasic::Dependency & dependency)
+{
+    FactorSet product;
+    for (auto position : dependency)
+    {
+        MergeFactorSets(product, factors[position]);
+    }
+    return std::all_of(product.begin(), product.end(), [](const auto & item) { return item.second % 2 == 0; });
+}
+
+TEST(GaussianBasic, chain)
 {
     std::vector<size_t> primes = {2, 3, 5, 7, 11, 13};
     std::vector<FactorSet> factors;
@@ -18,41 +30,29 @@ TEST(GaussianBasic, mask)
         factors.push_back(FactorizeBasic(primes[i] * primes[i + 1]));
     }
     auto gaus = GaussianBasic(factors, primes);
-    auto matrix = gaus.Solve();
-    for (size_t i = 0; i < matrix.size(); ++i)
-    {
-        boost::dynamic_bitset<> answer(6);
-        answer[i] = true;
-        answer[5] = true;
-        ASSERT_TRUE(answer == matrix[i].mask);
-    }
+    ASSERT_EQ(gaus.Solve(), 0);
+    ASSERT_FALSE(gaus.NextDependency().has_value());
 }
 
-TEST(GaussianBasic, participants)
+TEST(GaussianBasic, cycle)
 {
     std::vector<size_t> primes = {2, 3, 5, 7, 11, 13};
     std::vector<FactorSet> factors;
-    size_t test_size = primes.size() - 1;
-    for (size_t i = 0; i < test_size; ++i)
+    for (size_t i = 0; i < primes.size(); ++i)
     {
-        factors.push_back(FactorizeBasic(primes[i] * primes[i + 1]));
+        factors.push_back(FactorizeBasic(primes[i] * primes[(i + 1) % primes.size()]));
     }
     auto gaus = GaussianBasic(factors, primes);
-    auto matrix = gaus.Solve();
-    for (size_t i = 0; i < matrix.size(); ++i)
-    {
-        boost::dynamic_bitset<> answer(5);
-        for (size_t j = i; j < 5; ++j)
-        {
-            answer[j] = true;
-        }
-        ASSERT_TRUE(answer == matrix[i].participants);
-    }
+    ASSERT_EQ(gaus.Solve(), 1);
+    auto dependency = gaus.NextDependency();
+    ASSERT_TRUE(dependency.has_value());
+    ASSERT_EQ(dependency.value(), GaussianBasic::Dependency({0, 1, 2, 3, 4, 5}));
+    ASSERT_FALSE(gaus.NextDependency().has_value());
 }
 
 TEST(GaussianBasic, random)
 {
-    boost::mt19937 rng(42);
+    std::mt19937 rng(42);
     std::vector<size_t> primes = {2, 3, 5, 7, 11, 13};
     std::vector<FactorSet> factors;
     size_t test_size = 10;
@@ -63,16 +63,102 @@ TEST(GaussianBasic, random)
         factors.push_back(FactorizeBasic(tmp[0] * tmp[0] * tmp[1] * tmp[1] * tmp[2] * tmp[3]));
     }
     auto gaus = GaussianBasic(factors, primes);
-    auto matrix = gaus.Solve();
-    for (auto & line : matrix)
+    gaus.Solve();
+    auto dependency = gaus.NextDependency();
+    ASSERT_TRUE(dependency.has_value());
+    ASSERT_TRUE(IsSquare(factors, dependency.value()));
+}
+
+TEST(GaussianBasic, blocks)
+{
+    // several blocks of columns and rows that span a few words
+    std::mt19937 gen(7);
+    std::vector<size_t> primes = SievePrimes(3, 10'000);
+    primes.resize(300);
+    std::vector<FactorSet> factors(primes.size() + 20);
+    for (auto & factor : factors)
+    {
+        for (size_t i = 0; i < 12; ++i)
+        {
+            factor[primes[gen() % primes.size()]] += 1;
+        }
+        if (gen() % 2 == 0)
+        {
+            factor[-1] = 1;
+        }
+    }
+    auto gaus = GaussianBasic(factors, primes);
+    size_t amount = gaus.Solve();
+    ASSERT_GE(amount, 20);
+    std::set<GaussianBasic::Dependency> found;
+    while (auto dependency = gaus.NextDependency())
     {
-        if (line.mask.none())
+        ASSERT_FALSE(dependency->empty());
+        ASSERT_TRUE(std::is_sorted(dependency->begin(), dependency->end()));
+        ASSERT_TRUE(IsSquare(factors, dependency.value()));
+        found.insert(dependency.value());
+    }
+    ASSERT_EQ(found.size(), amount);
+}
+
+TEST(GaussianBasic, multiThread)
+{
+    // 3001 rows are split between two workers also on one core
+    ThreadGroup::ScopedThreadAmount amount(4);
+    std::mt19937 gen(11);
+    std::vector<size_t> primes = SievePrimes(3, 100'000);
+    primes.resize(3000);
+    std::vector<FactorSet> factors(primes.size() + 40);
+    for (auto & factor : factors)
+    {
+        for (size_t i = 0; i < 20; ++i)
         {
-            return;
+            factor[primes[gen() % primes.size()]] += 1;
         }
     }
+    auto single = GaussianBasic(factors, primes);
+    auto multi = GaussianBasic(factors, primes, true);
+    ASSERT_EQ(single.Solve(), multi.Solve());
+    while (auto dependency = single.NextDependency())
+    {
+        ASSERT_EQ(dependency, multi.NextDependency());
+    }
+    ASSERT_FALSE(multi.NextDependency().has_value());
+}
 
-    ASSERT_FALSE(true);
+TEST(IncrementalGaussian, dependencies)
+{
+    std::mt19937 gen(5);
+    std::vector<size_t> primes = SievePrimes(3, 10'000);
+    primes.resize(300);
+    std::vector<FactorSet> factors(primes.size() + 20);
+    for (auto & factor : factors)
+    {
+        for (size_t i = 0; i < 12; ++i)
+        {
+            factor[primes[gen() % primes.size()]] += 1;
+        }
+        if (gen() % 2 == 0)
+        {
+            factor[-1] = 1;
+        }
+    }
+    Relations relations(primes, factors);
+    IncrementalGaussian incremental(primes.size());
+    size_t found = 0;
+    for (size_t i = 0; i < relations.Size(); ++i)
+    {
+        auto dependency = incremental.Add(relations, i);
+        if (dependency.has_value())
+        {
+            // the relation closes its own dependency
+            ASSERT_EQ(dependency->back(), i);
+            ASSERT_TRUE(IsSquare(factors, dependency.value()));
+            ++found;
+        }
+    }
+    ASSERT_EQ(found + incremental.GetRank(), factors.size());
+    ASSERT_EQ(found, GaussianBasic(factors, primes).Solve());
 }
 
 };  // namespace
@@ -0,0 +1,70 @@
+#include "lanczos.hpp"
+#include "basic.hpp"
+#include "cfrac.hpp"
+#include "qs.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+
+using namespace lpn;  // NOLINT
+
+TEST(BlockLanczos, Dependencies)
+{
+    std::mt19937 gen(42);
+    std::vector<size_t> primes = SievePrimes(3, 20'000);
+    primes.resize(1500);
+    FactorSets factors(primes.size() + 40);
+    for (auto & factor : factors)
+    {
+        for (size_t i = 0; i < 20; ++i)
+        {
+            factor[primes[gen() % primes.size()]] += 1 + gen() % 3;
+        }
+        if (gen() % 2 == 0)
+        {
+            factor[-1] = 1;
+        }
+    }
+
+    auto dependencies = BlockLanczos(factors, primes).Solve();
+    ASSERT_GE(dependencies.size(), 10);
+    for (const auto & dependency : dependencies)
+    {
+        ASSERT_FALSE(dependency.empty());
+        FactorSet product;
+        for (auto i : dependency)
+        {
+            for (const auto & [prime, power] : factors[i])
+            {
+                product[prime] += power;
+            }
+        }
+        for (const auto & [prime, power] : product)
+        {
+            ASSERT_EQ(power % 2, 0);
+        }
+    }
+}
+
+TEST(BlockLanczos, SelfInitializingSieve)
+{
+    long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+    auto config = Sieve::CreateSelfInitializingConfig(n).SetLinearSolver(LinearSolver::kBlockLanczos);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(BlockLanczos, ContinuedFractions)
+{
+    long_int n("106456777608740439414017801971");  // 341727233806069 * 311525588473159
+    FactorSet factor = ContinuedFractionsFactorization::Factorize(n, 200, "", LinearSolver::kBlockLanczos);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+};  // namespace
@@ -0,0 +1,68 @@
+#include "montgomery.hpp"
+#include "basic.hpp"
+
+#include <gtest/gtest.h>
+#include <random>
+
+namespace
+{
+using namespace lpn;  // NOLINT
+
+long_int RandomNumber(std::mt19937_64 & gen, size_t bits)
+{
+    long_int value = 0;
+    for (size_t i = 0; i < bits; i += 64)
+    {
+        value = (value << 64) | gen();
+    }
+    return value >> (value == 0 ? 0 : msb(value) + 1 - bits);
+}
+
+template <size_t N>
+void CheckArithmetic(size_t bits)
+{
+    std::mt19937_64 gen(bits);
+    for (size_t i = 0; i < 200; ++i)
+    {
+        long_int n = RandomNumber(gen, bits) | 1 | (long_int(1) << (bits - 1));
+        Montgomery<N> field(n);
+        long_int a = RandomNumber(gen, bits) % n;
+        long_int b = RandomNumber(gen, bits) % n;
+        auto x = field.Convert(a);
+        auto y = field.Convert(b);
+        ASSERT_EQ(field.Multiply(x, y), field.Convert(a * b));
+        ASSERT_EQ(field.Add(x, y), field.Convert(a + b));
+        ASSERT_EQ(field.Subtract(x, y), field.Convert(a - b));
+        ASSERT_EQ(field.Multiply(x, field.GetOne()), x);
+        ASSERT_EQ(field.Gcd(x), lpn::gcd(n, a));
+        // a common factor of n and a, when the product fits
+        long_int p = 1000003;
+        if (msb(n * p) < 64 * N)
+        {
+            Montgomery<N> multiple(n * p);
+            ASSERT_EQ(multiple.Gcd(multiple.Convert(a * p)), p * lpn::gcd(n, a));
+        }
+    }
+}
+
+TEST(Montgomery, Arithmetic)
+{
+    CheckArithmetic<1>(40);
+    CheckArithmetic<1>(64);
+    CheckArithmetic<2>(100);
+    CheckArithmetic<2>(128);
+    CheckArithmetic<3>(190);
+    CheckArithmetic<4>(230);
+    CheckArithmetic<8>(500);
+}
+
+TEST(Montgomery, Zero)
+{
+    long_int n = 1000003ull * 998244353ull;
+    Montgomery<1> field(n);
+    auto zero = field.Convert(n);
+    ASSERT_TRUE(Montgomery<1>::IsZero(zero));
+    ASSERT_EQ(field.Gcd(zero), n);
+    ASSERT_EQ(field.Subtract(field.GetOne(), field.GetOne()), zero);
+}
+};  // namespace
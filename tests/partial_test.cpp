@@ -0,0 +1,73 @@
+#include "partial.hpp"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+
+using namespace lpn;  // NOLINT
+
+bool IsSquare(const FactorSet & factor)
+{
+    return std::all_of(factor.begin(), factor.end(), [](const auto & item) { return item.second % 2 == 0; });
+}
+
+TEST(PartialRelations, SingleLargePrime)
+{
+    long_int n = 1'000'003;
+    Solution solution;
+    PartialRelations partials(n);
+    ASSERT_FALSE(partials.Add(10, {{2, 1}, {101, 1}}, 1, 101, solution));
+    ASSERT_FALSE(partials.Add(11, {{3, 1}, {103, 1}}, 1, 103, solution));
+    ASSERT_TRUE(partials.Add(12, {{2, 1}, {3, 2}, {101, 1}}, 1, 101, solution));
+
+    ASSERT_EQ(partials.Cycles(), 1);
+    ASSERT_EQ(solution.values.size(), 1);
+    ASSERT_EQ(solution.values[0], 120);
+    ASSERT_EQ(solution.factors.GetFactor(0).at(101), 2);
+    ASSERT_EQ(solution.factors.GetFactor(0).at(2), 2);
+}
+
+TEST(PartialRelations, DoubleLargePrimeCycle)
+{
+    long_int n = 1'000'003;
+    Solution solution;
+    PartialRelations partials(n);
+    // 1 - 101 - 103 - 1 is a cycle of three partial relations
+    ASSERT_FALSE(partials.Add(2, {{5, 1}, {101, 1}}, 1, 101, solution));
+    ASSERT_FALSE(partials.Add(3, {{5, 1}, {101, 1}, {103, 1}}, 101, 103, solution));
+    ASSERT_FALSE(partials.Add(5, {{107, 1}, {109, 1}}, 107, 109, solution));
+    ASSERT_TRUE(partials.Add(7, {{103, 1}}, 1, 103, solution));
+
+    ASSERT_EQ(partials.Size(), 3);
+    ASSERT_EQ(solution.values.size(), 1);
+    ASSERT_EQ(solution.values[0], 42);
+    ASSERT_TRUE(IsSquare(solution.factors.GetFactor(0)));
+}
+
+TEST(PartialRelations, SquareOfLargePrime)
+{
+    Solution solution;
+    PartialRelations partials(1'000'003);
+    ASSERT_TRUE(partials.Add(4, {{3, 2}, {101, 2}}, 101, 101, solution));
+    ASSERT_TRUE(IsSquare(solution.factors.GetFactor(0)));
+}
+
+TEST(PartialRelations, DuplicateValue)
+{
+    long_int n = 1'000'003;
+    Solution solution;
+    PartialRelations partials(n);
+    ASSERT_FALSE(partials.Add(10, {{2, 1}, {101, 1}, {103, 1}}, 101, 103, solution));
+    // the same relation found again, and the one of the negative value, close no cycle
+    ASSERT_FALSE(partials.Add(10, {{2, 1}, {101, 1}, {103, 1}}, 101, 103, solution));
+    ASSERT_FALSE(partials.Add(n - 10, {{2, 1}, {101, 1}, {103, 1}}, 101, 103, solution));
+    ASSERT_EQ(partials.Cycles(), 0);
+    ASSERT_EQ(partials.Size(), 1);
+    ASSERT_TRUE(solution.values.empty());
+
+    ASSERT_TRUE(partials.Add(11, {{3, 2}, {101, 1}, {103, 1}}, 101, 103, solution));
+    ASSERT_EQ(partials.Cycles(), 1);
+}
+
+};  // namespace
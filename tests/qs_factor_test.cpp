@@ -1,7 +1,10 @@
 #include "qs.hpp"
+#include "thread_group.hpp"
 
 #include <gtest/gtest.h>
 
+#include <set>
+
 namespace
 {
 
@@ -10,7 +13,8 @@ using namespace lpn;  // NOLINT
 TEST(Sieve, QuadraticSieve)
 {
     long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
-    FactorSet factor = QuadraticSieveFactorization::Factorize(n);
+    auto config = Sieve::CreateConfig(n, 50'000'000, 2000, 1.5);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
     ASSERT_EQ(factor.size(), 2);
     ASSERT_EQ(Eval(factor), n);
 }
@@ -24,4 +28,175 @@ TEST(Sieve, QuadraticSieveWithConfig)
     ASSERT_EQ(Eval(factor), n);
 }
 
+TEST(Sieve, SelfInitializingSieve)
+{
+    long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+    auto config = Sieve::CreateSelfInitializingConfig(n);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(Sieve, SelfInitializingSieveWithConfig)
+{
+    long_int n("4482406424966880742829846540605971439398287609");  // 86738535685150523290199 * 51677220390685710220591
+    auto config = Sieve::CreateSelfInitializingConfig(n, 100'000, 2000, 1.5);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(Sieve, SelfInitializingSieveLargePrimes)
+{
+    long_int n("4482406424966880742829846540605971439398287609");  // 86738535685150523290199 * 51677220390685710220591
+    auto config = Sieve::CreateSelfInitializingConfig(n, 100'000, 2000, 1.2).SetLargePrimes(30);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(Sieve, SelfInitializingSieveDoubleLargePrimes)
+{
+    long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+    auto config = Sieve::CreateSelfInitializingConfig(n).SetLargePrimes(30, true);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(Sieve, SelfInitializingSieveSmallPrimeVariation)
+{
+    long_int n("4482406424966880742829846540605971439398287609");  // 86738535685150523290199 * 51677220390685710220591
+    auto config = Sieve::CreateSelfInitializingConfig(n, 100'000, 2000, 1.5).SetSmallPrimeVariation(256, 1'000'000);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(Sieve, QuadraticSieveMultiThread)
+{
+    long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+    auto config = Sieve::CreateConfig(n, 50'000'000, 2000, 1.5, true);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(Sieve, SelfInitializingSieveMultiThread)
+{
+    long_int n("4482406424966880742829846540605971439398287609");  // 86738535685150523290199 * 51677220390685710220591
+    auto config = Sieve::CreateSelfInitializingConfig(n, 100'000, 2000, 1.5, true);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(Sieve, SelfInitializingSieveMultiThreadLargePrimes)
+{
+    long_int n("4482406424966880742829846540605971439398287609");  // 86738535685150523290199 * 51677220390685710220591
+    auto config = Sieve::CreateSelfInitializingConfig(n, 100'000, 2000, 1.2, true).SetLargePrimes(30);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(Sieve, SelfInitializingSieveFourThreads)
+{
+    // the sieve pool, the verifiers and the batches of square roots run on four threads also on one core
+    ThreadGroup::ScopedThreadAmount amount(4);
+    long_int n("4482406424966880742829846540605971439398287609");  // 86738535685150523290199 * 51677220390685710220591
+    auto config = Sieve::CreateSelfInitializingConfig(n, 100'000, 2000, 1.5, true);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor, FactorSet({{long_int("86738535685150523290199"), 1}, {long_int("51677220390685710220591"), 1}}));
+}
+
+TEST(Sieve, SelfInitializingSieveRunsOutOfA)
+{
+    // a 19 digit n has few values of A near the target, the others are taken farther from it
+    long_int n("1000000016000000063");  // 1000000007 * 1000000009
+    auto config = Sieve::CreateSelfInitializingConfig(n, 32'768, 200, 1.5);
+    Solution solution = Sieve::Solve(n, config);
+    ASSERT_TRUE(solution.complete);
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor.size(), 2);
+    ASSERT_EQ(Eval(factor), n);
+}
+
+TEST(Sieve, SelfInitializingSieveDistinctRelations)
+{
+    // polynomials with different A find the same small values, each of them is one relation
+    long_int n("10000000000427000000001443");  // 1000000000039 * 10000000000037
+    auto config = Sieve::CreateSelfInitializingConfig(n, 32'768, 200, 1.5).SetLinearSolver(LinearSolver::kGaussian);
+    Solution solution = Sieve::Solve(n, config);
+    std::set<long_int> keys;
+    for (const auto & value : solution.values)
+    {
+        ASSERT_TRUE(keys.insert(PartialRelations::ComputeKey(value, n)).second);
+    }
+    FactorSet factor = QuadraticSieveFactorization::Factorize(n, config);
+    ASSERT_EQ(factor, FactorSet({{long_int("1000000000039"), 1}, {long_int("10000000000037"), 1}}));
+}
+
+TEST(Sieve, ShortSolution)
+{
+    // the interval has too few relations, the solution says so and the number is not split
+    long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+    auto config = Sieve::CreateConfig(n, 10'000, 2000, 1.5);
+    ASSERT_FALSE(Sieve::Solve(n, config).complete);
+    ASSERT_EQ(QuadraticSieveFactorization::Factorize(n, config), FactorSet({{n, 1}}));
+}
+
+TEST(Sieve, DefaultConfigBySize)
+{
+    // below the first row of the table the smallest parameters are used, down to a few digits
+    for (const char * number :
+         {"389719890467", "7574146875964063", "388528751143360367", "1000000016000000063", "44424520521173988649",
+          "2657432200776026735197", "6520501483631092099624739", "10000000000427000000001443",
+          "106456777608740439414017801971", "58717599841872556859253593232217536127549734735469"})
+    {
+        long_int n(number);
+        FactorSet factor = QuadraticSieveFactorization::Factorize(n);
+        ASSERT_EQ(factor.size(), 2);
+        ASSERT_EQ(Eval(factor), n);
+    }
+}
+
+TEST(Sieve, RelationsKeepSign)
+{
+    long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+    for (auto config : {Sieve::CreateConfig(n, 1'000'000, 500, 1.5), Sieve::CreateSelfInitializingConfig(n)})
+    {
+        Solution solution = Sieve::Solve(n, config);
+        size_t negative = 0;
+        for (size_t i = 0; i < solution.values.size(); ++i)
+        {
+            negative += solution.factors.GetFactor(i).contains(-1);
+            ASSERT_EQ((solution.values[i] * solution.values[i] - Eval(solution.factors.GetFactor(i))) % n, 0);
+        }
+        ASSERT_GT(negative, 0);
+    }
+}
+
+TEST(Sieve, IncrementalStopsEarly)
+{
+    long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+    auto config = Sieve::CreateSelfInitializingConfig(n).SetLinearSolver(LinearSolver::kIncremental);
+    Solution solution = Sieve::Solve(n, config);
+    ASSERT_EQ(solution.factor.size(), 2);
+    ASSERT_EQ(Eval(solution.factor), n);
+    ASSERT_LT(solution.factors.Size(), solution.primes.size());
+}
+
+TEST(Sieve, IncrementalStopsEarlyMultiThread)
+{
+    // the verifier threads reduce the full and the combined partial relations
+    long_int n("59469489332848408438249254427481121839977");  // 338555568168236555657 * 175656509371887105761
+    auto config = Sieve::CreateSelfInitializingConfig(n, 100'000, 1000, 1.2, true)
+                      .SetLargePrimes(30)
+                      .SetLinearSolver(LinearSolver::kIncremental);
+    Solution solution = Sieve::Solve(n, config);
+    ASSERT_EQ(solution.factor.size(), 2);
+    ASSERT_EQ(Eval(solution.factor), n);
+}
+
 };  // namespace
@@ -0,0 +1,85 @@
+#include "relations.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+namespace
+{
+
+using namespace lpn;  // NOLINT
+
+TEST(Relations, RoundTrip)
+{
+    Relations relations({2, 3, 5, 7});
+    relations.Add({{-1, 1}, {3, 2}, {7, 1}});
+    relations.Add({{2, 3}, {11, 1}});
+    relations.Add(FactorSet{});
+
+    ASSERT_EQ(relations.Size(), 3);
+    ASSERT_EQ(relations.GetBaseSize(), 4);
+    // 11 is out of the factor base and takes the next index
+    ASSERT_EQ(relations.GetPrimeAmount(), 5);
+    ASSERT_EQ(relations.GetPrime(4), 11);
+
+    ASSERT_EQ(relations.GetFactor(0), FactorSet({{-1, 1}, {3, 2}, {7, 1}}));
+    ASSERT_EQ(relations.GetFactor(1), FactorSet({{2, 3}, {11, 1}}));
+    ASSERT_TRUE(relations.GetFactor(2).empty());
+
+    auto span = relations.GetIndices(0);
+    std::vector<uint32_t> indices(span.begin(), span.end());
+    std::sort(indices.begin(), indices.end());
+    ASSERT_EQ(indices, std::vector<uint32_t>({1, 3, Relations::kSign}));
+}
+
+TEST(Relations, LargePower)
+{
+    Relations relations({2, 3});
+    relations.Add({{2, 600}, {3, 1}});
+
+    // 600 = 255 + 255 + 90
+    ASSERT_EQ(relations.GetIndices(0).size(), 4);
+    ASSERT_EQ(relations.GetFactor(0), FactorSet({{2, 600}, {3, 1}}));
+}
+
+TEST(Relations, Append)
+{
+    Relations first({2, 3});
+    first.Add({{2, 1}, {13, 1}});
+    Relations second({2, 3});
+    second.Add({{3, 1}, {17, 1}});
+    second.Add(FactorSet{{13, 2}});
+
+    first.Append(second);
+    ASSERT_EQ(first.Size(), 3);
+    ASSERT_EQ(first.GetPrimeAmount(), 4);
+    ASSERT_EQ(first.GetFactor(1), FactorSet({{3, 1}, {17, 1}}));
+    ASSERT_EQ(first.GetFactor(2), FactorSet({{13, 2}}));
+    ASSERT_EQ(first.GetIndices(2)[0], 2);
+}
+
+TEST(Relations, SharedIndex)
+{
+    auto index = Relations::CreateIndex({2, 3, 5});
+    Relations first(index);
+    Relations second(index);
+    first.Add({{5, 1}, {13, 1}});
+    second.Add({{2, 1}, {17, 1}});
+
+    // the large primes are not shared
+    ASSERT_EQ(first.GetPrime(3), 13);
+    ASSERT_EQ(second.GetPrime(3), 17);
+    ASSERT_EQ(index->primes.size(), 3);
+
+    first.Append(second);
+    ASSERT_EQ(first.GetPrimeAmount(), 5);
+    ASSERT_EQ(first.GetFactor(1), FactorSet({{2, 1}, {17, 1}}));
+
+    // only the large primes of the selected relations are kept
+    Relations selected = first.Select({1});
+    ASSERT_EQ(selected.Size(), 1);
+    ASSERT_EQ(selected.GetPrimeAmount(), 4);
+    ASSERT_EQ(selected.GetFactor(0), FactorSet({{2, 1}, {17, 1}}));
+}
+
+};  // namespace
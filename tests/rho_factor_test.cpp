@@ -45,4 +45,27 @@ TEST(RhoFactorization, Heavy)
         ASSERT_TRUE(Eval(factor) == value);
     }
 }
+
+TEST(RhoFactorization, OddWidths)
+{
+    // odd numbers of every width of the Montgomery arithmetic and one above it
+    std::vector<long_int> primes = {long_int(1000003), long_int(998244353), long_int("4294967311")};
+    for (size_t bits : {60, 120, 180, 250, 500, 600})
+    {
+        long_int rest = 1;
+        while (msb(rest) + 32 < bits)
+        {
+            rest = rest * 1000000007 + 2;
+            rest |= 1;
+        }
+        for (const auto & p : primes)
+        {
+            long_int value = p * rest;
+            auto factor = RhoFactorization::Factorize(value, 2);
+
+            ASSERT_TRUE(factor.size() >= 2);
+            ASSERT_TRUE(Eval(factor) == value);
+        }
+    }
+}
 };  // namespace
@@ -0,0 +1,162 @@
+#include "bounded_queue.hpp"
+#include "thread_group.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+namespace
+{
+
+using namespace lpn;  // NOLINT
+
+TEST(ThreadGroup, SetThreadAmount)
+{
+    int hardware = ThreadGroup::GetThreadAmount();
+    ThreadGroup::SetThreadAmount(4);
+    ASSERT_EQ(ThreadGroup::GetThreadAmount(), 4);
+    ThreadGroup::SetThreadAmount(0);
+    ASSERT_EQ(ThreadGroup::GetThreadAmount(), hardware);
+}
+
+TEST(ThreadGroup, ScopedThreadAmount)
+{
+    int hardware = ThreadGroup::GetThreadAmount();
+    {
+        ThreadGroup::ScopedThreadAmount amount(4);
+        ASSERT_EQ(ThreadGroup::GetThreadAmount(), 4);
+        {
+            ThreadGroup::ScopedThreadAmount inner(2);
+            ASSERT_EQ(ThreadGroup::GetThreadAmount(), 2);
+        }
+        ASSERT_EQ(ThreadGroup::GetThreadAmount(), 4);
+    }
+    ASSERT_EQ(ThreadGroup::GetThreadAmount(), hardware);
+}
+
+TEST(WorkStealingPool, ComputesAllTasks)
+{
+    std::atomic<size_t> sum = 0;
+    std::vector<std::atomic<size_t>> calls(4);
+    {
+        WorkStealingPool pool(4);
+        for (size_t i = 1; i <= 1000; ++i)
+        {
+            pool.AddTask(
+                [i, &sum, &calls](size_t worker)
+                {
+                    sum += i;
+                    calls[worker]++;
+                });
+        }
+        pool.Wait();
+        ASSERT_EQ(sum, 500'500);
+    }
+    size_t total = 0;
+    for (auto & count : calls)
+    {
+        total += count;
+    }
+    ASSERT_EQ(total, 1000);
+}
+
+TEST(WorkStealingPool, WaitsForBacklog)
+{
+    std::atomic<size_t> done = 0;
+    WorkStealingPool pool(2);
+    for (size_t i = 0; i < 100; ++i)
+    {
+        pool.AddTask([&done](size_t) { done++; });
+        pool.Wait(4);
+        ASSERT_GE(done + 4, i + 1);
+    }
+    pool.Wait();
+    ASSERT_EQ(done, 100);
+}
+
+TEST(WorkStealingPool, StealsFromBusyWorker)
+{
+    // the first task blocks its worker until the rest are done by the other one
+    std::atomic<size_t> done = 0;
+    WorkStealingPool pool(2);
+    pool.AddTask(
+        [&done](size_t)
+        {
+            while (done < 10)
+            {
+                std::this_thread::yield();
+            }
+        });
+    for (size_t i = 0; i < 10; ++i)
+    {
+        pool.AddTask([&done](size_t) { done++; });
+    }
+    pool.Wait();
+    ASSERT_EQ(done, 10);
+}
+
+TEST(BoundedQueue, KeepsOrderAndCapacity)
+{
+    BoundedQueue<size_t> queue(4);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(queue.TryPush(size_t(i)));
+    }
+    ASSERT_FALSE(queue.TryPush(4));
+    size_t value;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(queue.TryPop(value));
+        ASSERT_EQ(value, i);
+    }
+    ASSERT_FALSE(queue.TryPop(value));
+}
+
+TEST(BoundedQueue, ManyProducersAndConsumers)
+{
+    constexpr size_t kProducers = 3;
+    constexpr size_t kValues = 10'000;
+    BoundedQueue<std::vector<size_t>> queue(16);
+    std::atomic<size_t> sum = 0;
+    std::atomic<size_t> popped = 0;
+    std::vector<std::thread> threads;
+    for (size_t producer = 0; producer < kProducers; ++producer)
+    {
+        threads.emplace_back(
+            [&queue]()
+            {
+                for (size_t i = 1; i <= kValues; ++i)
+                {
+                    std::vector<size_t> value = {i};
+                    while (!queue.TryPush(std::move(value)))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+    for (size_t consumer = 0; consumer < 2; ++consumer)
+    {
+        threads.emplace_back(
+            [&queue, &sum, &popped]()
+            {
+                std::vector<size_t> value;
+                while (popped < kProducers * kValues)
+                {
+                    if (queue.TryPop(value))
+                    {
+                        sum += value[0];
+                        popped++;
+                    }
+                }
+            });
+    }
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(sum, kProducers * kValues * (kValues + 1) / 2);
+}
+
+};  // namespace
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <memory>
+
+namespace lpn
+{
+// Lock-free bounded queue for many producers and many consumers. Every cell carries a sequence number that tells
+// whether it is free for the producer of a given position or filled for its consumer.
+template <typename T>
+class BoundedQueue
+{
+   public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity_(std::bit_ceil(std::max<size_t>(2, capacity))),
+          cells_(std::make_unique<Cell[]>(capacity_)),
+          head_(0),
+          tail_(0)
+    {
+        for (size_t pos = 0; pos < capacity_; ++pos)
+        {
+            cells_[pos].sequence.store(pos, std::memory_order_relaxed);
+        }
+    }
+
+    // the value is moved from only when the push succeeds
+    bool TryPush(T && value)
+    {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell & cell = cells_[pos & (capacity_ - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence == pos)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < pos)
+            {
+                return false;
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPop(T & value)
+    {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell & cell = cells_[pos & (capacity_ - 1)];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence == pos + 1)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.value);
+                    cell.sequence.store(pos + capacity_, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < pos + 1)
+            {
+                return false;
+            }
+            else
+            {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+   private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t capacity_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
+};  // namespace lpn
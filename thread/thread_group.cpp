@@ -14,6 +14,16 @@ void ThreadGroup::ComputeAllTasks()
     }
 }
 
-int ThreadGroup::GetThreadAmount() { return std::max<int>(2, std::thread::hardware_concurrency()) - 1; }
+int ThreadGroup::GetThreadAmount()
+{
+    int amount = amount_;
+    return amount > 0 ? amount : std::max<int>(2, std::thread::hardware_concurrency()) - 1;
+}
+
+void ThreadGroup::SetThreadAmount(int amount) { amount_ = amount; }
+
+ThreadGroup::ScopedThreadAmount::ScopedThreadAmount(int amount) : previous_(amount_.exchange(amount)) {}
+
+ThreadGroup::ScopedThreadAmount::~ScopedThreadAmount() { amount_ = previous_; }
 
 }  // namespace lpn
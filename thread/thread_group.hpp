@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <thread>
 #include <vector>
 
@@ -8,6 +9,17 @@ namespace lpn
 class ThreadGroup
 {
    public:
+    // SetThreadAmount for the lifetime of the object, the previous amount is restored after it
+    class ScopedThreadAmount
+    {
+       public:
+        explicit ScopedThreadAmount(int amount);
+        ~ScopedThreadAmount();
+
+       private:
+        int previous_;
+    };
+
     explicit ThreadGroup();
 
     void ComputeAllTasks();
@@ -19,8 +31,12 @@ class ThreadGroup
     }
 
     static int GetThreadAmount();
+    // overrides the amount of the hardware, e.g. to run the multi thread paths on one core; 0 restores it
+    static void SetThreadAmount(int amount);
 
    private:
+    static inline std::atomic<int> amount_ = 0;
+
     std::vector<std::thread> threads_;
 };
 };  // namespace lpn
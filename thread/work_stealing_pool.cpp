@@ -0,0 +1,109 @@
+#include "work_stealing_pool.hpp"
+
+namespace lpn
+{
+
+WorkStealingPool::WorkStealingPool(size_t workers)
+    : queues_(std::max<size_t>(1, workers)), queued_(0), pending_(0), next_queue_(0), stop_(false)
+{
+    for (size_t worker = 0; worker < queues_.size(); ++worker)
+    {
+        threads_.emplace_back([this, worker]() { Run(worker); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    Wait();
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    task_added_.notify_all();
+    for (auto & thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::AddTask(Task task)
+{
+    size_t worker;
+    {
+        std::lock_guard lock(mutex_);
+        worker = next_queue_;
+        next_queue_ = (next_queue_ + 1) % queues_.size();
+        ++pending_;
+        ++queued_;
+    }
+    {
+        std::lock_guard lock(queues_[worker].mutex);
+        queues_[worker].tasks.push_back(std::move(task));
+    }
+    task_added_.notify_one();
+}
+
+void WorkStealingPool::Wait(size_t pending)
+{
+    std::unique_lock lock(mutex_);
+    task_done_.wait(lock, [this, pending]() { return pending_ <= pending; });
+}
+
+size_t WorkStealingPool::GetWorkerAmount() const { return queues_.size(); }
+
+void WorkStealingPool::Run(size_t worker)
+{
+    while (true)
+    {
+        Task task;
+        if (TryPop(worker, task))
+        {
+            task(worker);
+            {
+                std::lock_guard lock(mutex_);
+                --pending_;
+            }
+            task_done_.notify_all();
+            continue;
+        }
+
+        std::unique_lock lock(mutex_);
+        task_added_.wait(lock, [this]() { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0)
+        {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::TryPop(size_t worker, Task & task)
+{
+    for (size_t shift = 0; shift < queues_.size(); ++shift)
+    {
+        auto & queue = queues_[(worker + shift) % queues_.size()];
+        {
+            std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty())
+            {
+                continue;
+            }
+            // the owner works from the back, thieves take the oldest task from the front
+            if (shift == 0)
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+        std::lock_guard lock(mutex_);
+        --queued_;
+        return true;
+    }
+    return false;
+}
+
+}  // namespace lpn
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lpn
+{
+// Fixed set of workers with a task deque each. A worker takes its own newest task first and steals the oldest task
+// of another worker when its deque is empty, so uneven tasks do not leave threads idle.
+class WorkStealingPool
+{
+   public:
+    using Task = std::function<void(size_t worker)>;
+
+    explicit WorkStealingPool(size_t workers);
+    ~WorkStealingPool();
+
+    void AddTask(Task task);
+    void Wait(size_t pending = 0);
+
+    size_t GetWorkerAmount() const;
+
+   private:
+    struct alignas(64) Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Run(size_t worker);
+    bool TryPop(size_t worker, Task & task);
+
+   private:
+    std::vector<Queue> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable task_added_;
+    std::condition_variable task_done_;
+    size_t queued_;
+    size_t pending_;
+    size_t next_queue_;
+    bool stop_;
+};
+};  // namespace lpn